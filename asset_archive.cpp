@@ -0,0 +1,60 @@
+#include "asset_archive.h"
+
+const u8 ASSET_MAGIC[4] = { 'T', 'P', 'A', 'K' };
+
+bool asset_archive_open(Asset_Archive *archive, const char *path)
+{
+    archive->entries = 0;
+    archive->entry_count = 0;
+    if (!map_file(path, &archive->file))
+    {
+        return false;
+    }
+    const u8 *data = archive->file.data;
+    size_t size = archive->file.size;
+    if (size < ASSET_HEADER_SIZE || memcmp(data, ASSET_MAGIC, 4) != 0 ||
+        (data[4] | data[5] << 8) != ASSET_ARCHIVE_VERSION)
+    {
+        unmap_file(&archive->file);
+        return false;
+    }
+    u32 count = data[6] | data[7] << 8;
+    if (size < ASSET_HEADER_SIZE + count * sizeof(Asset_Entry))
+    {
+        unmap_file(&archive->file);
+        return false;
+    }
+    const Asset_Entry *entries = (const Asset_Entry *)(data + ASSET_HEADER_SIZE);
+    for (u32 i = 0;i < count;++i)
+    {
+        const Asset_Entry *entry = entries + i;
+        if (entry->offset > size || entry->size > size - entry->offset ||
+            entry->samples_offset > entry->size || entry->name[ASSET_NAME_SIZE - 1] != 0)
+        {
+            unmap_file(&archive->file);
+            return false;
+        }
+    }
+    archive->entries = entries;
+    archive->entry_count = count;
+    return true;
+}
+
+void asset_archive_close(Asset_Archive *archive)
+{
+    unmap_file(&archive->file);
+    archive->entries = 0;
+    archive->entry_count = 0;
+}
+
+const Asset_Entry *asset_find(const Asset_Archive *archive, const char *name)
+{
+    for (u32 i = 0;i < archive->entry_count;++i)
+    {
+        if (strcmp(archive->entries[i].name, name) == 0)
+        {
+            return archive->entries + i;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+
+#include <stddef.h>
+#include "game.h"
+#include "mapped_file.h"
+
+// Asset archive, all integers little-endian:
+//   header   "TPAK", u16 version, u16 entry count
+//   entries  Asset_Entry for each asset
+//   data     the assets, each starting on an ASSET_ALIGNMENT boundary
+// Sounds are stored as WAV files already decoded to the mixer's format, with
+// their samples aligned, so the game can hand the samples to the mixer in
+// place when the device matches and decode the WAV otherwise.
+
+#define ASSET_ARCHIVE_PATH "assets.pak"
+#define ASSET_ARCHIVE_VERSION 1
+#define ASSET_HEADER_SIZE 8
+#define ASSET_ALIGNMENT 64
+#define ASSET_NAME_SIZE 32
+// SDL's AUDIO_S16LSB, spelled out so the packer does not need SDL.
+#define ASSET_AUDIO_S16LSB 0x8010
+
+#define ASSET_FONT "font"
+#define ASSET_MUSIC "music"
+#define ASSET_LINE_CLEAR "line_clear"
+#define ASSET_LEVEL_UP "level_up"
+#define ASSET_GAME_OVER "game_over"
+
+enum Asset_Kind
+{
+    ASSET_RAW,
+    ASSET_SOUND
+};
+
+struct Asset_Entry
+{
+    char name[ASSET_NAME_SIZE];
+    u32 kind;
+    // Sounds only: the sample format, and where the samples start within
+    // the asset.
+    u32 frequency;
+    u16 format;
+    u16 channels;
+    u32 samples_offset;
+    u64 offset;
+    u64 size;
+};
+
+static_assert(sizeof(Asset_Entry) == 64, "asset entry layout");
+
+struct Asset_Archive
+{
+    Mapped_File file;
+    const Asset_Entry *entries;
+    u32 entry_count;
+};
+
+// Maps the archive and checks that every entry lies within it.
+bool asset_archive_open(Asset_Archive *archive, const char *path);
+void asset_archive_close(Asset_Archive *archive);
+const Asset_Entry *asset_find(const Asset_Archive *archive, const char *name);
+
+inline const u8 *asset_data(const Asset_Archive *archive, const Asset_Entry *entry)
+{
+    return archive->file.data + entry->offset;
+}
+
+#endif
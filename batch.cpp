@@ -0,0 +1,316 @@
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "batch.h"
+#include "replay.h"
+
+struct Random_Policy_State
+{
+    bool seeded;
+    Rng rng;
+};
+
+void random_policy(const Game_State *game, Input_State *input, void *state, const void *)
+{
+    Random_Policy_State *random = (Random_Policy_State *)state;
+    if (!random->seeded)
+    {
+        rng_seed(&random->rng, ~game->seed);
+        random->seeded = true;
+    }
+    u64 bits = rng_next(&random->rng);
+    input->left = (bits & 0x7) == 0;
+    input->right = ((bits >> 3) & 0x7) == 0;
+    input->up = ((bits >> 6) & 0x7) == 0;
+    input->down = ((bits >> 9) & 0xF) == 0;
+    input->a = ((bits >> 13) & 0x3F) == 0;
+}
+
+const Input_Policy RANDOM_POLICY = { "random", random_policy, sizeof(Random_Policy_State), 0 };
+
+#define BATCH_SCORE_BUFFER 4096
+
+// Results wait in a buffer per worker and go to the log a buffer at a time.
+struct alignas(CACHE_LINE_SIZE) Score_Buffer
+{
+    u32 count;
+    Score_Record records[BATCH_SCORE_BUFFER];
+};
+
+struct Batch_Job
+{
+    const Batch_Config *config;
+    Batch_Stats *stats;
+    u8 *policy_states;
+    int policy_state_stride;
+    Leaderboard_Writer scores;
+    Score_Buffer *score_buffers;
+    std::mutex scores_lock;
+    bool scores_failed;
+    u32 time;
+};
+
+inline int histogram_bucket(u64 value)
+{
+    int bucket = 0;
+    while (value && bucket < HISTOGRAM_BUCKETS - 1)
+    {
+        value >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+u64 batch_game_seed(u64 seed, u32 game_index)
+{
+    u64 z = seed + (game_index + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+int play_game(Game_State *game, const Input_Policy *policy, void *policy_state,
+              u64 seed, int start_level, Randomizer randomizer, int max_ticks,
+              const char *record_path)
+{
+    game_init(game, seed, randomizer);
+    game_begin(game, start_level);
+    memset(policy_state, 0, policy->state_size);
+
+    Replay_Writer writer;
+    bool recording = false;
+    if (record_path)
+    {
+        recording = replay_writer_open(&writer, record_path, game);
+        if (!recording)
+        {
+            fprintf(stderr, "cannot write replay %s\n", record_path);
+        }
+    }
+
+    Input_State input = {};
+    int ticks = 0;
+    while (game->phase != GAME_GAMEOVER && ticks < max_ticks)
+    {
+        Input_State prev_input = input;
+        policy->update(game, &input, policy_state, policy->config);
+        input_update_edges(&input, &prev_input);
+        if (recording)
+        {
+            replay_writer_tick(&writer, &input);
+        }
+        update_game(game, &input);
+        ++ticks;
+    }
+    if (recording && !replay_writer_close(&writer, game))
+    {
+        fprintf(stderr, "cannot write replay %s\n", record_path);
+    }
+    return ticks;
+}
+
+void record_game(Batch_Stats *stats, const Game_State *game, int ticks)
+{
+    if (stats->games == 0 || game->points < stats->points_min)
+    {
+        stats->points_min = game->points;
+    }
+    if (stats->games == 0 || game->points > stats->points_max)
+    {
+        stats->points_max = game->points;
+    }
+    if (stats->games == 0 || game->line_count < stats->lines_min)
+    {
+        stats->lines_min = game->line_count;
+    }
+    if (stats->games == 0 || game->line_count > stats->lines_max)
+    {
+        stats->lines_max = game->line_count;
+    }
+    ++stats->games;
+    stats->ticks += ticks;
+    stats->points_sum += game->points;
+    stats->lines_sum += game->line_count;
+    ++stats->points_histogram[histogram_bucket(game->points)];
+    ++stats->lines_histogram[histogram_bucket(game->line_count)];
+    ++stats->ticks_histogram[histogram_bucket(ticks)];
+}
+
+void merge_stats(Batch_Stats *into, const Batch_Stats *from)
+{
+    if (from->games == 0)
+    {
+        return;
+    }
+    if (into->games == 0)
+    {
+        *into = *from;
+        return;
+    }
+    into->games += from->games;
+    into->ticks += from->ticks;
+    into->points_sum += from->points_sum;
+    into->lines_sum += from->lines_sum;
+    into->points_min = from->points_min < into->points_min ? from->points_min : into->points_min;
+    into->points_max = from->points_max > into->points_max ? from->points_max : into->points_max;
+    into->lines_min = from->lines_min < into->lines_min ? from->lines_min : into->lines_min;
+    into->lines_max = from->lines_max > into->lines_max ? from->lines_max : into->lines_max;
+    for (int i = 0;i < HISTOGRAM_BUCKETS;++i)
+    {
+        into->points_histogram[i] += from->points_histogram[i];
+        into->lines_histogram[i] += from->lines_histogram[i];
+        into->ticks_histogram[i] += from->ticks_histogram[i];
+    }
+}
+
+void flush_scores(Batch_Job *job, Score_Buffer *buffer)
+{
+    std::lock_guard<std::mutex> lock(job->scores_lock);
+    if (!job->scores_failed && !leaderboard_append(&job->scores, buffer->records, buffer->count))
+    {
+        job->scores_failed = true;
+    }
+    buffer->count = 0;
+}
+
+void batch_body(u32 begin, u32 end, int worker, void *user)
+{
+    Batch_Job *job = (Batch_Job *)user;
+    const Batch_Config *config = job->config;
+    Batch_Stats *stats = job->stats + worker;
+    void *policy_state = job->policy_states + worker * job->policy_state_stride;
+
+    Game_State game;
+    char record_path[1024];
+    for (u32 index = begin;index < end;++index)
+    {
+        if (config->record_dir)
+        {
+            snprintf(record_path, sizeof(record_path), "%s/game_%08u.trpl",
+                     config->record_dir, index);
+        }
+        int ticks = play_game(&game, &config->policy, policy_state,
+                              batch_game_seed(config->seed, index),
+                              config->start_level, config->randomizer,
+                              config->max_ticks,
+                              config->record_dir ? record_path : 0);
+        record_game(stats, &game, ticks);
+        if (job->score_buffers)
+        {
+            Score_Buffer *buffer = job->score_buffers + worker;
+            score_record_from_game(&game, ticks, config->score_source, job->time,
+                                   buffer->records + buffer->count++);
+            if (buffer->count == BATCH_SCORE_BUFFER)
+            {
+                flush_scores(job, buffer);
+            }
+        }
+    }
+}
+
+void run_batch(const Batch_Config *config, Batch_Result *result)
+{
+    Thread_Pool *pool = thread_pool_create(config->thread_count);
+    int thread_count = thread_pool_size(pool);
+
+    Batch_Job job;
+    job.config = config;
+    job.stats = new Batch_Stats[thread_count]();
+    job.policy_state_stride = (config->policy.state_size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    job.policy_states = (u8 *)::operator new[](job.policy_state_stride * thread_count + 1,
+                                               std::align_val_t(CACHE_LINE_SIZE));
+    job.score_buffers = 0;
+    job.scores_failed = false;
+    job.time = (u32)time(0);
+    if (config->score_log)
+    {
+        if (leaderboard_writer_open(&job.scores, config->score_log))
+        {
+            job.score_buffers = new Score_Buffer[thread_count];
+            for (int i = 0;i < thread_count;++i)
+            {
+                job.score_buffers[i].count = 0;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "cannot open score log %s\n", config->score_log);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    thread_pool_for(pool, config->game_count, 64, batch_body, &job);
+    auto stop = std::chrono::steady_clock::now();
+
+    memset(&result->stats, 0, sizeof(result->stats));
+    for (int i = 0;i < thread_count;++i)
+    {
+        merge_stats(&result->stats, job.stats + i);
+    }
+    result->seconds = std::chrono::duration<double>(stop - start).count();
+
+    if (job.score_buffers)
+    {
+        for (int i = 0;i < thread_count;++i)
+        {
+            flush_scores(&job, job.score_buffers + i);
+        }
+        if (!leaderboard_writer_close(&job.scores) || job.scores_failed)
+        {
+            fprintf(stderr, "cannot write score log %s\n", config->score_log);
+        }
+        delete[] job.score_buffers;
+    }
+
+    ::operator delete[](job.policy_states, std::align_val_t(CACHE_LINE_SIZE));
+    delete[] job.stats;
+    thread_pool_destroy(pool);
+}
+
+void print_histogram(const char *title, const u64 *histogram)
+{
+    int last = 0;
+    u64 peak = 0;
+    for (int i = 0;i < HISTOGRAM_BUCKETS;++i)
+    {
+        if (histogram[i])
+        {
+            last = i;
+        }
+        peak = histogram[i] > peak ? histogram[i] : peak;
+    }
+    printf("%s\n", title);
+    for (int i = 0;i <= last;++i)
+    {
+        u64 low = i == 0 ? 0 : 1ull << (i - 1);
+        u64 high = i == 0 ? 0 : (1ull << i) - 1;
+        int bar = peak ? (int)(histogram[i] * 40 / peak) : 0;
+        printf("  %10llu - %-10llu %10llu ", (unsigned long long)low,
+               (unsigned long long)high, (unsigned long long)histogram[i]);
+        for (int j = 0;j < bar;++j)
+        {
+            putchar('#');
+        }
+        putchar('\n');
+    }
+}
+
+void print_batch_result(const Batch_Config *config, const Batch_Result *result)
+{
+    const Batch_Stats *stats = &result->stats;
+    double games = stats->games ? (double)stats->games : 1.0;
+    printf("policy: %s, games: %llu, seed: %llu\n", config->policy.name,
+           (unsigned long long)stats->games, (unsigned long long)config->seed);
+    printf("time: %.3f s, games/sec: %.0f, ticks/sec: %.0f\n", result->seconds,
+           stats->games / result->seconds, stats->ticks / result->seconds);
+    printf("points: avg %.1f, min %d, max %d\n", stats->points_sum / games,
+           stats->points_min, stats->points_max);
+    printf("lines: avg %.2f, min %d, max %d\n", stats->lines_sum / games,
+           stats->lines_min, stats->lines_max);
+    printf("ticks: avg %.1f\n", stats->ticks / games);
+    print_histogram("points histogram:", stats->points_histogram);
+    print_histogram("lines histogram:", stats->lines_histogram);
+    print_histogram("game length (ticks) histogram:", stats->ticks_histogram);
+}
@@ -0,0 +1,64 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "game.h"
+#include "leaderboard.h"
+#include "thread_pool.h"
+
+#define HISTOGRAM_BUCKETS 32
+
+typedef void Policy_Function(const Game_State *game, Input_State *input,
+                             void *state, const void *config);
+
+struct Input_Policy
+{
+    const char *name;
+    Policy_Function *update;
+    int state_size;
+    const void *config;
+};
+
+struct Batch_Config
+{
+    u32 game_count;
+    u64 seed;
+    int thread_count;
+    int start_level;
+    Randomizer randomizer;
+    int max_ticks;
+    Input_Policy policy;
+    const char *record_dir;
+    // Appends a result for every game to this score log when set.
+    const char *score_log;
+    Score_Source score_source;
+};
+
+struct alignas(CACHE_LINE_SIZE) Batch_Stats
+{
+    u64 games;
+    u64 ticks;
+    u64 points_sum;
+    u64 lines_sum;
+    int points_min, points_max;
+    int lines_min, lines_max;
+    u64 points_histogram[HISTOGRAM_BUCKETS];
+    u64 lines_histogram[HISTOGRAM_BUCKETS];
+    u64 ticks_histogram[HISTOGRAM_BUCKETS];
+};
+
+struct Batch_Result
+{
+    Batch_Stats stats;
+    double seconds;
+};
+
+extern const Input_Policy RANDOM_POLICY;
+
+u64 batch_game_seed(u64 seed, u32 game_index);
+int play_game(Game_State *game, const Input_Policy *policy, void *policy_state,
+              u64 seed, int start_level, Randomizer randomizer, int max_ticks,
+              const char *record_path = 0);
+void run_batch(const Batch_Config *config, Batch_Result *result);
+void print_batch_result(const Batch_Config *config, const Batch_Result *result);
+
+#endif
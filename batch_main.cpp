@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bot.h"
+
+void print_usage(const char *program)
+{
+    printf("usage: %s [-n games] [-t threads] [-s seed] [-l start_level]\n"
+           "          [-m max_ticks] [-p policy] [--bag]\n"
+           "          [-d bot_depth] [-c bot_cache_megabytes] [-r replay_dir]\n"
+           "          [-o score_log]\n"
+           "policies: random, bot\n", program);
+}
+
+const Input_Policy *find_policy(const char *name)
+{
+    const Input_Policy *policies[] = { &RANDOM_POLICY, &BOT_POLICY };
+    for (int i = 0;i < (int)ARRAY_COUNT(policies);++i)
+    {
+        if (strcmp(policies[i]->name, name) == 0)
+        {
+            return policies[i];
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    Batch_Config config = {};
+    config.game_count = 10000;
+    config.seed = 1;
+    config.max_ticks = 60 * 60 * TICKS_PER_SECOND;
+    config.randomizer = RANDOMIZER_UNIFORM;
+    config.policy = RANDOM_POLICY;
+
+    Bot_Config bot_config = DEFAULT_BOT_CONFIG;
+    int cache_megabytes = 0;
+
+    for (int i = 1;i < argc;++i)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : 0;
+        if (strcmp(arg, "--bag") == 0)
+        {
+            config.randomizer = RANDOMIZER_BAG;
+            continue;
+        }
+        if (!value || arg[0] != '-' || strlen(arg) != 2)
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+        switch (arg[1])
+        {
+        case 'n':
+            config.game_count = (u32)strtoul(value, 0, 10);
+            break;
+        case 't':
+            config.thread_count = atoi(value);
+            break;
+        case 's':
+            config.seed = strtoull(value, 0, 10);
+            break;
+        case 'l':
+            config.start_level = atoi(value);
+            break;
+        case 'm':
+            config.max_ticks = atoi(value);
+            break;
+        case 'd':
+            bot_config.depth = atoi(value);
+            break;
+        case 'c':
+            cache_megabytes = atoi(value);
+            break;
+        case 'r':
+            config.record_dir = value;
+            break;
+        case 'o':
+            config.score_log = value;
+            break;
+        case 'p':
+        {
+            const Input_Policy *policy = find_policy(value);
+            if (!policy)
+            {
+                fprintf(stderr, "unknown policy: %s\n", value);
+                return 1;
+            }
+            config.policy = *policy;
+        } break;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+        ++i;
+    }
+
+    Transposition_Table table;
+    if (cache_megabytes > 0)
+    {
+        tt_init(&table, (size_t)cache_megabytes << 20);
+        bot_config.table = &table;
+    }
+    config.score_source = SCORE_SOURCE_RANDOM;
+    if (config.policy.update == BOT_POLICY.update)
+    {
+        config.policy.config = &bot_config;
+        config.score_source = SCORE_SOURCE_BOT;
+    }
+
+    Batch_Result result;
+    run_batch(&config, &result);
+    print_batch_result(&config, &result);
+
+    if (bot_config.table)
+    {
+        tt_free(&table);
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <string.h>
+#include "bench.h"
+#include "bot.h"
+#include "profile.h"
+
+#define BENCH_MAX_GAME_TICKS (20 * 60 * TICKS_PER_SECOND)
+
+int capture_game(Bench_Fixtures *fixtures, int capacity, const Input_Policy *policy,
+                 u64 seed, int stride, int limit)
+{
+    u8 *policy_state = new u8[policy->state_size]();
+    Game_State game;
+    game_init(&game, seed, RANDOMIZER_BAG);
+    game_begin(&game, 0);
+
+    Input_State input = {};
+    int captured = 0;
+    for (int tick = 0;tick < BENCH_MAX_GAME_TICKS && game.phase != GAME_GAMEOVER;++tick)
+    {
+        Input_State prev_input = input;
+        policy->update(&game, &input, policy_state, policy->config);
+        input_update_edges(&input, &prev_input);
+        update_game(&game, &input);
+        if ((game.events & GAME_EVENT_PIECE_LOCK) && game.piece_count % stride == 0)
+        {
+            fixtures->states[fixtures->count++] = game;
+            if (++captured == limit || fixtures->count == capacity)
+            {
+                break;
+            }
+        }
+    }
+    delete[] policy_state;
+    return captured;
+}
+
+void bench_make_fixtures(Bench_Fixtures *fixtures, u64 seed, int count)
+{
+    fixtures->states = new Game_State[count];
+    fixtures->count = 0;
+    fixtures->seed = seed;
+    // Bot games give tall, busy boards with line clears; random games give
+    // the ragged boards a new player leaves behind.
+    for (u32 index = 0;fixtures->count < count && index < (u32)count * 4;++index)
+    {
+        u64 game_seed = batch_game_seed(seed, index);
+        if (index % 2 == 0)
+        {
+            capture_game(fixtures, count, &BOT_POLICY, game_seed, 7, 16);
+        }
+        else
+        {
+            capture_game(fixtures, count, &RANDOM_POLICY, game_seed, 2, 8);
+        }
+    }
+}
+
+void bench_free_fixtures(Bench_Fixtures *fixtures)
+{
+    delete[] fixtures->states;
+    fixtures->states = 0;
+    fixtures->count = 0;
+}
+
+void bench_run(const Bench_Case *bench, const Bench_Fixtures *fixtures, void *user,
+               u64 min_ns, Bench_Result *result)
+{
+    double samples[BENCH_SAMPLES];
+    u64 checksum = 0;
+    u64 pass_ops = 0;
+    for (int sample = 0;sample < BENCH_SAMPLES;++sample)
+    {
+        u64 elapsed = 0;
+        u64 ops = 0;
+        while (elapsed < min_ns || ops == 0)
+        {
+            if (bench->setup)
+            {
+                bench->setup(fixtures, user);
+            }
+            checksum = 0;
+            u64 start = profile_time();
+            pass_ops = bench->run(fixtures, user, &checksum);
+            elapsed += profile_time() - start;
+            ops += pass_ops;
+        }
+        samples[sample] = (double)elapsed / (double)ops;
+    }
+    std::sort(samples, samples + BENCH_SAMPLES);
+
+    result->name = bench->name;
+    result->fixtures = fixtures->count;
+    result->ops = pass_ops;
+    result->ns_per_op = samples[BENCH_SAMPLES / 2];
+    result->checksum = checksum;
+}
+
+void bench_print_header(FILE *file)
+{
+    fprintf(file, "benchmark,fixtures,ops_per_pass,ns_per_op,checksum\n");
+}
+
+void bench_print_result(FILE *file, const Bench_Result *result)
+{
+    fprintf(file, "%s,%d,%llu,%.3f,%016llx\n", result->name, result->fixtures,
+            (unsigned long long)result->ops, result->ns_per_op,
+            (unsigned long long)result->checksum);
+    fflush(file);
+}
@@ -0,0 +1,57 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include "game.h"
+
+#define BENCH_SAMPLES 5
+
+// Game states taken right after a piece locks, from seeded bot and random
+// games. The same seed always gives the same fixtures.
+struct Bench_Fixtures
+{
+    Game_State *states;
+    int count;
+    u64 seed;
+};
+
+// setup runs before every timed pass and is not timed. run does one pass
+// over the fixtures, returns the number of operations it did and mixes its
+// results into checksum, which starts at 0 on every pass. Every pass must do
+// the same work, so the checksum only depends on the fixtures.
+typedef void Bench_Setup(const Bench_Fixtures *fixtures, void *user);
+typedef u64 Bench_Run(const Bench_Fixtures *fixtures, void *user, u64 *checksum);
+
+struct Bench_Case
+{
+    const char *name;
+    Bench_Setup *setup;
+    Bench_Run *run;
+};
+
+struct Bench_Result
+{
+    const char *name;
+    int fixtures;
+    u64 ops;
+    double ns_per_op;
+    u64 checksum;
+};
+
+void bench_make_fixtures(Bench_Fixtures *fixtures, u64 seed, int count);
+void bench_free_fixtures(Bench_Fixtures *fixtures);
+
+inline u64 bench_mix(u64 checksum, u64 value)
+{
+    checksum ^= value + 0x9E3779B97F4A7C15ull + (checksum << 6) + (checksum >> 2);
+    return checksum;
+}
+
+// Repeats the case until each sample has run for min_ns of timed passes and
+// reports the median of BENCH_SAMPLES samples.
+void bench_run(const Bench_Case *bench, const Bench_Fixtures *fixtures, void *user,
+               u64 min_ns, Bench_Result *result);
+void bench_print_header(FILE *file);
+void bench_print_result(FILE *file, const Bench_Result *result);
+
+#endif
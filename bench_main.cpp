@@ -0,0 +1,484 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "bot.h"
+#include "event_ring.h"
+#include "snapshot.h"
+
+struct Bench_Scratch
+{
+    Game_State *states;
+    Placement_List placements;
+    Bot bot;
+    u8 *policy_state;
+    Game_Snapshot *snapshots;
+    Snapshot_Ring ring;
+    Event_Ring events;
+};
+
+void copy_states(const Bench_Fixtures *fixtures, void *user)
+{
+    Bench_Scratch *scratch = (Bench_Scratch *)user;
+    memcpy(scratch->states, fixtures->states, fixtures->count * sizeof(Game_State));
+}
+
+void copy_states_with_lines(const Bench_Fixtures *fixtures, void *user)
+{
+    Bench_Scratch *scratch = (Bench_Scratch *)user;
+    copy_states(fixtures, user);
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        Game_State *game = scratch->states + i;
+        game->pending_line_count = find_lines<WIDTH, HEIGHT>(game->board.rows, game->lines);
+    }
+}
+
+u64 bench_check_piece_valid(const Bench_Fixtures *fixtures, void *, u64 *checksum)
+{
+    u64 ops = 0;
+    u64 valid = 0;
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        const Game_State *game = fixtures->states + i;
+        Piece_State piece = game->piece;
+        for (piece.rotation = 0;piece.rotation < 4;++piece.rotation)
+        {
+            for (piece.offset_row = 0;piece.offset_row < HEIGHT;++piece.offset_row)
+            {
+                for (piece.offset_col = -2;piece.offset_col < WIDTH;++piece.offset_col)
+                {
+                    valid += check_piece_valid<WIDTH, HEIGHT>(&piece, game->board.rows);
+                    ++ops;
+                }
+            }
+        }
+    }
+    *checksum = bench_mix(*checksum, valid);
+    return ops;
+}
+
+u64 bench_drop_distance(const Bench_Fixtures *fixtures, void *, u64 *checksum)
+{
+    u64 ops = 0;
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        const Game_State *game = fixtures->states + i;
+        Piece_State piece = game->piece;
+        piece.offset_row = 0;
+        for (piece.rotation = 0;piece.rotation < 4;++piece.rotation)
+        {
+            const Tetrino_Shape *shape = tetrino_shape(piece.tetrino_index, piece.rotation);
+            for (piece.offset_col = -shape->min_col;
+                 piece.offset_col + shape->max_col < WIDTH;++piece.offset_col)
+            {
+                int distance = drop_distance<WIDTH, HEIGHT>(&piece, game->board.columns);
+                *checksum = bench_mix(*checksum, distance);
+                ++ops;
+            }
+        }
+    }
+    return ops;
+}
+
+u64 bench_merge_piece(const Bench_Fixtures *fixtures, void *user, u64 *checksum)
+{
+    Bench_Scratch *scratch = (Bench_Scratch *)user;
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        merge_piece(scratch->states + i);
+        *checksum = bench_mix(*checksum, scratch->states[i].board_hash);
+    }
+    return fixtures->count;
+}
+
+u64 bench_find_lines(const Bench_Fixtures *fixtures, void *, u64 *checksum)
+{
+    u8 lines[HEIGHT];
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        int count = find_lines<WIDTH, HEIGHT>(fixtures->states[i].board.rows, lines);
+        *checksum = bench_mix(*checksum, count);
+    }
+    return fixtures->count;
+}
+
+u64 bench_clear_lines(const Bench_Fixtures *fixtures, void *user, u64 *checksum)
+{
+    Bench_Scratch *scratch = (Bench_Scratch *)user;
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        Game_State *game = scratch->states + i;
+        clear_lines<WIDTH, HEIGHT>(game->board.cells, game->board.rows, game->lines,
+                                   &game->board_hash);
+        *checksum = bench_mix(*checksum, game->board_hash);
+    }
+    return fixtures->count;
+}
+
+u64 bench_tetrino_get(const Bench_Fixtures *fixtures, void *, u64 *checksum)
+{
+    u64 ops = 0;
+    u64 sum = 0;
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        const Khoigach *khoigach = KHOIGACH + fixtures->states[i].piece.tetrino_index;
+        for (int rotation = 0;rotation < 4;++rotation)
+        {
+            for (int row = 0;row < khoigach->side;++row)
+            {
+                for (int col = 0;col < khoigach->side;++col)
+                {
+                    sum = sum * 31 + tetrino_get(khoigach, row, col, rotation);
+                    ++ops;
+                }
+            }
+        }
+    }
+    *checksum = bench_mix(*checksum, sum);
+    return ops;
+}
+
+u64 bench_count_points(const Bench_Fixtures *fixtures, void *, u64 *checksum)
+{
+    u64 ops = 0;
+    u64 sum = 0;
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        int level = fixtures->states[i].level;
+        for (int line_count = 0;line_count <= 4;++line_count)
+        {
+            sum += count_points(level, line_count);
+            ++ops;
+        }
+    }
+    *checksum = bench_mix(*checksum, sum);
+    return ops;
+}
+
+u64 bench_update_game(const Bench_Fixtures *fixtures, void *user, u64 *checksum)
+{
+    Bench_Scratch *scratch = (Bench_Scratch *)user;
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        Game_State *game = scratch->states + i;
+        Input_State input = {};
+        input_set_keys(&input, (u8)(i & 0x1F), 0, 0);
+        update_game(game, &input);
+        *checksum = bench_mix(*checksum, game_hash(game));
+    }
+    return fixtures->count;
+}
+
+u64 bench_generate_placements(const Bench_Fixtures *fixtures, void *user, u64 *checksum)
+{
+    Bench_Scratch *scratch = (Bench_Scratch *)user;
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        const Game_State *game = fixtures->states + i;
+        int count = generate_placements(game->board.rows, &game->piece, &scratch->placements);
+        *checksum = bench_mix(*checksum, count);
+    }
+    return fixtures->count;
+}
+
+u64 bench_bot_choose(const Bench_Fixtures *fixtures, void *user, u64 *checksum)
+{
+    Bench_Scratch *scratch = (Bench_Scratch *)user;
+    Placement placement;
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        const Game_State *game = fixtures->states + i;
+        if (bot_choose(&scratch->bot, game, &placement))
+        {
+            *checksum = bench_mix(*checksum, zobrist_piece(&placement.piece));
+        }
+    }
+    return fixtures->count;
+}
+
+u64 bench_bot_game(const Bench_Fixtures *fixtures, void *user, u64 *checksum)
+{
+    Bench_Scratch *scratch = (Bench_Scratch *)user;
+    Game_State game;
+    int ticks = play_game(&game, &BOT_POLICY, scratch->policy_state, fixtures->seed, 0,
+                          RANDOMIZER_BAG, 60 * TICKS_PER_SECOND);
+    *checksum = bench_mix(*checksum, game_hash(&game));
+    return ticks;
+}
+
+void save_snapshots(const Bench_Fixtures *fixtures, void *user)
+{
+    Bench_Scratch *scratch = (Bench_Scratch *)user;
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        snapshot_save(fixtures->states + i, scratch->snapshots + i);
+    }
+}
+
+u64 bench_snapshot_save(const Bench_Fixtures *fixtures, void *user, u64 *checksum)
+{
+    Bench_Scratch *scratch = (Bench_Scratch *)user;
+    save_snapshots(fixtures, user);
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        *checksum = bench_mix(*checksum, scratch->snapshots[i].rows[HEIGHT - 1]);
+    }
+    return fixtures->count;
+}
+
+u64 bench_snapshot_load(const Bench_Fixtures *fixtures, void *user, u64 *checksum)
+{
+    Bench_Scratch *scratch = (Bench_Scratch *)user;
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        Game_State *game = scratch->states + i;
+        snapshot_load(scratch->snapshots + i, game);
+        *checksum = bench_mix(*checksum, game->board.columns[i % WIDTH]);
+    }
+    return fixtures->count;
+}
+
+// Steps every fixture through the ring for a second of ticks and rolls each
+// back to the start once, so rollback is counted per resimulated tick.
+u64 bench_rollback(const Bench_Fixtures *fixtures, void *user, u64 *checksum)
+{
+    Bench_Scratch *scratch = (Bench_Scratch *)user;
+    Snapshot_Ring *ring = &scratch->ring;
+    u64 ops = 0;
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        Game_State *game = scratch->states + i;
+        snapshot_ring_reset(ring, 0, 0);
+        for (int tick = 0;tick < TICKS_PER_SECOND;++tick)
+        {
+            snapshot_ring_step(ring, game, (u8)(tick / 7 % 3), 0);
+        }
+        snapshot_ring_set_keys(ring, 0, INPUT_KEY_UP, INPUT_KEY_UP);
+        snapshot_ring_rollback(ring, game, 0);
+        *checksum = bench_mix(*checksum, game_hash(game));
+        ops += TICKS_PER_SECOND * 2;
+    }
+    return ops;
+}
+
+// The game only plays WIDTH by HEIGHT. This tiles each fixture's board into a
+// W by H board, bottom rows lined up so full lines stay full, runs the board
+// kernels on it and checks them: the bit rows against the cells after the
+// clear, and every drop distance against stepping down with
+// check_piece_valid.
+template <int W, int H>
+u64 bench_board_kernels(const Bench_Fixtures *fixtures, void *, u64 *checksum)
+{
+    typedef typename Board<W, H>::Row Row;
+    Board<W, H> board;
+    u8 lines[H];
+    u64 ops = 0;
+    bool valid = true;
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        const Game_State *game = fixtures->states + i;
+        for (int row = 0;row < H;++row)
+        {
+            int src_row = HEIGHT - 1 - (H - 1 - row) % HEIGHT;
+            board.rows[row] = 0;
+            for (int col = 0;col < W;++col)
+            {
+                u8 value = game->board.cells[src_row * WIDTH + col % WIDTH];
+                board.cells[row * W + col] = value;
+                board.rows[row] |= (Row)(value != 0) << col;
+            }
+        }
+        int count = find_lines<W, H>(board.rows, lines);
+        clear_lines<W, H>(board.cells, board.rows, lines, 0);
+        build_columns<W, H>(board.rows, board.columns);
+        *checksum = bench_mix(*checksum, count);
+        ++ops;
+        for (int row = 0;row < H;++row)
+        {
+            for (int col = 0;col < W;++col)
+            {
+                valid = valid && ((board.rows[row] >> col) & 1) == (board.cells[row * W + col] != 0);
+            }
+        }
+
+        Piece_State piece = game->piece;
+        piece.offset_row = 0;
+        for (piece.rotation = 0;piece.rotation < 4;++piece.rotation)
+        {
+            const Tetrino_Shape *shape = tetrino_shape(piece.tetrino_index, piece.rotation);
+            for (piece.offset_col = -shape->min_col;
+                 piece.offset_col + shape->max_col < W;++piece.offset_col)
+            {
+                if (!check_piece_valid<W, H>(&piece, board.rows))
+                {
+                    continue;
+                }
+                int distance = drop_distance<W, H>(&piece, board.columns);
+                Piece_State landed = piece;
+                landed.offset_row += distance;
+                valid = valid && check_piece_valid<W, H>(&landed, board.rows);
+                ++landed.offset_row;
+                valid = valid && !check_piece_valid<W, H>(&landed, board.rows);
+                *checksum = bench_mix(*checksum, distance);
+                ++ops;
+            }
+        }
+    }
+    if (!valid)
+    {
+        fprintf(stderr, "board kernels disagree at %d by %d\n", W, H);
+        exit(1);
+    }
+    return ops;
+}
+
+// Publishes every fixture's events with a flag of each kind set and reads
+// them back through one cursor, so each op is one push and one pop.
+u64 bench_event_ring(const Bench_Fixtures *fixtures, void *user, u64 *checksum)
+{
+    Bench_Scratch *scratch = (Bench_Scratch *)user;
+    Event_Ring *events = &scratch->events;
+    Event_Cursor cursor;
+    event_cursor_init(events, &cursor);
+    u64 ops = 0;
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        Game_State game = fixtures->states[i];
+        game.events = GAME_EVENT_PIECE_LOCK | GAME_EVENT_LINE_CLEAR | GAME_EVENT_LEVEL_UP;
+        event_ring_publish(events, &game);
+        Event_Record event;
+        while (event_ring_pop(events, &cursor, &event))
+        {
+            *checksum = bench_mix(*checksum, event.type ^ event.cleared_rows ^ (u32)event.points);
+            ++ops;
+        }
+    }
+    return ops;
+}
+
+const Bench_Case BENCH_CASES[] = {
+    { "check_piece_valid", 0, bench_check_piece_valid },
+    { "drop_distance", 0, bench_drop_distance },
+    { "merge_piece", copy_states, bench_merge_piece },
+    { "find_lines", 0, bench_find_lines },
+    { "clear_lines", copy_states_with_lines, bench_clear_lines },
+    { "tetrino_get", 0, bench_tetrino_get },
+    { "count_points", 0, bench_count_points },
+    { "update_game", copy_states, bench_update_game },
+    { "generate_placements", 0, bench_generate_placements },
+    { "bot_choose", 0, bench_bot_choose },
+    { "bot_game_tick", 0, bench_bot_game },
+    { "snapshot_save", 0, bench_snapshot_save },
+    { "snapshot_load", save_snapshots, bench_snapshot_load },
+    { "snapshot_step_and_rollback", copy_states, bench_rollback },
+    { "board_kernels_4x20", 0, bench_board_kernels<4, 20> },
+    { "board_kernels_40x60", 0, bench_board_kernels<40, 60> },
+    { "event_ring_push_pop", 0, bench_event_ring },
+};
+
+void print_usage(const char *program)
+{
+    printf("usage: %s [-s seed] [-n fixtures] [-t min_ms_per_sample]\n"
+           "          [-f name_filter] [-o csv_file] [-l]\n", program);
+}
+
+int main(int argc, char* argv[])
+{
+    u64 seed = 1;
+    int fixture_count = 256;
+    int min_ms = 20;
+    const char *filter = 0;
+    const char *output_path = 0;
+
+    for (int i = 1;i < argc;++i)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : 0;
+        if (strcmp(arg, "-l") == 0)
+        {
+            for (int j = 0;j < (int)ARRAY_COUNT(BENCH_CASES);++j)
+            {
+                printf("%s\n", BENCH_CASES[j].name);
+            }
+            return 0;
+        }
+        if (!value || arg[0] != '-' || strlen(arg) != 2)
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+        switch (arg[1])
+        {
+        case 's':
+            seed = strtoull(value, 0, 10);
+            break;
+        case 'n':
+            fixture_count = atoi(value);
+            break;
+        case 't':
+            min_ms = atoi(value);
+            break;
+        case 'f':
+            filter = value;
+            break;
+        case 'o':
+            output_path = value;
+            break;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+        ++i;
+    }
+    if (fixture_count <= 0 || min_ms <= 0)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    FILE *output = output_path ? fopen(output_path, "w") : stdout;
+    if (!output)
+    {
+        fprintf(stderr, "cannot write %s\n", output_path);
+        return 1;
+    }
+
+    Bench_Fixtures fixtures;
+    bench_make_fixtures(&fixtures, seed, fixture_count);
+
+    Bench_Scratch *scratch = new Bench_Scratch;
+    scratch->states = new Game_State[fixtures.count];
+    scratch->policy_state = new u8[BOT_POLICY.state_size]();
+    scratch->snapshots = new Game_Snapshot[fixtures.count];
+    snapshot_ring_init(&scratch->ring, TICKS_PER_SECOND);
+    event_ring_init(&scratch->events, EVENT_RING_CAPACITY);
+    bot_init(&scratch->bot, &DEFAULT_BOT_CONFIG);
+
+    bench_print_header(output);
+    for (int i = 0;i < (int)ARRAY_COUNT(BENCH_CASES);++i)
+    {
+        const Bench_Case *bench = BENCH_CASES + i;
+        if (filter && !strstr(bench->name, filter))
+        {
+            continue;
+        }
+        Bench_Result result;
+        bench_run(bench, &fixtures, scratch, (u64)min_ms * 1000000, &result);
+        bench_print_result(output, &result);
+    }
+
+    bot_free(&scratch->bot);
+    snapshot_ring_free(&scratch->ring);
+    event_ring_free(&scratch->events);
+    delete[] scratch->snapshots;
+    delete[] scratch->policy_state;
+    delete[] scratch->states;
+    delete scratch;
+    bench_free_fixtures(&fixtures);
+    if (output != stdout)
+    {
+        fclose(output);
+    }
+    return 0;
+}
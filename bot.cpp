@@ -0,0 +1,248 @@
+#include <string.h>
+#include "bot.h"
+
+#define TOPPED_OUT_VALUE -1e9f
+
+const Bot_Config DEFAULT_BOT_CONFIG = {
+    { -0.51f, 0.76f, -0.36f, -0.18f, -0.05f, -0.02f },
+    1,
+    0
+};
+
+void bot_init(Bot *bot, const Bot_Config *config)
+{
+    bot->config = *config;
+    board_batch_init(&bot->batch, MAX_PLACEMENTS);
+    board_features_init(&bot->features, MAX_PLACEMENTS);
+}
+
+void bot_free(Bot *bot)
+{
+    board_batch_free(&bot->batch);
+    board_features_free(&bot->features);
+}
+
+float score_features(const Bot_Weights *weights, const Board_Features *features, int index)
+{
+    int capacity = features->capacity;
+    int height = 0;
+    int wells = 0;
+    for (int col = 0;col < WIDTH;++col)
+    {
+        height += features->heights[col * capacity + index];
+        wells += features->wells[col * capacity + index];
+    }
+    return weights->height * height
+        + weights->holes * features->holes[index]
+        + weights->bumpiness * features->bumpiness[index]
+        + weights->wells * wells
+        + weights->row_transitions * features->row_transitions[index];
+}
+
+void expand_ply(Bot_Ply *ply, const u16 *rows, u64 hash, const Piece_State *piece)
+{
+    generate_placements(rows, piece, &ply->placements);
+    for (int i = 0;i < ply->placements.count;++i)
+    {
+        ply->hashes[i] = hash;
+        ply->lines_cleared[i] = apply_placement(rows, &ply->placements.placements[i].piece,
+                                                ply->rows[i], ply->hashes + i);
+    }
+}
+
+void evaluate_leaves(Bot *bot, Bot_Ply *ply)
+{
+    const Bot_Config *config = &bot->config;
+    int miss_count = 0;
+    bot->batch.count = 0;
+    for (int i = 0;i < ply->placements.count;++i)
+    {
+        if (ply->rows[i][0])
+        {
+            ply->values[i] = TOPPED_OUT_VALUE;
+            continue;
+        }
+        if (config->table && tt_probe(config->table, ply->hashes[i], 0, ply->values + i))
+        {
+            continue;
+        }
+        bot->misses[miss_count++] = i;
+        board_batch_add(&bot->batch, ply->rows[i]);
+    }
+    evaluate_board_batch(&bot->batch, &bot->features);
+    for (int miss = 0;miss < miss_count;++miss)
+    {
+        int i = bot->misses[miss];
+        ply->values[i] = score_features(&config->weights, &bot->features, miss);
+        if (config->table)
+        {
+            tt_store(config->table, ply->hashes[i], 0, ply->values[i]);
+        }
+    }
+}
+
+float best_value(const Bot *bot, const Bot_Ply *ply, int *best_index)
+{
+    float best = TOPPED_OUT_VALUE;
+    *best_index = -1;
+    for (int i = 0;i < ply->placements.count;++i)
+    {
+        if (ply->values[i] <= TOPPED_OUT_VALUE)
+        {
+            continue;
+        }
+        float value = ply->values[i] + bot->config.weights.lines * ply->lines_cleared[i];
+        if (*best_index < 0 || value > best)
+        {
+            best = value;
+            *best_index = i;
+        }
+    }
+    return best;
+}
+
+float lookahead_value(Bot *bot, const u16 *rows, u64 hash, u8 next_tetrino)
+{
+    Transposition_Table *table = bot->config.table;
+    u64 key = hash ^ ZOBRIST.next_pieces[0][next_tetrino];
+    float value;
+    if (table && tt_probe(table, key, 1, &value))
+    {
+        return value;
+    }
+    Piece_State spawn = {};
+    spawn.tetrino_index = next_tetrino;
+    spawn.offset_col = WIDTH / 2;
+
+    Bot_Ply *ply = bot->plies + 1;
+    expand_ply(ply, rows, hash, &spawn);
+    evaluate_leaves(bot, ply);
+    int best_index;
+    value = best_value(bot, ply, &best_index);
+    if (table)
+    {
+        tt_store(table, key, 1, value);
+    }
+    return value;
+}
+
+bool bot_choose(Bot *bot, const Game_State *game, Placement *out)
+{
+    Bot_Ply *ply = bot->plies;
+    expand_ply(ply, game->board.rows, game->board_hash, &game->piece);
+    if (bot->config.depth < 2)
+    {
+        evaluate_leaves(bot, ply);
+    }
+    else
+    {
+        for (int i = 0;i < ply->placements.count;++i)
+        {
+            ply->values[i] = ply->rows[i][0] ? TOPPED_OUT_VALUE
+                : lookahead_value(bot, ply->rows[i], ply->hashes[i], game->next_pieces[0]);
+        }
+    }
+    int best_index;
+    best_value(bot, ply, &best_index);
+    if (best_index < 0)
+    {
+        return false;
+    }
+    *out = ply->placements.placements[best_index];
+    return true;
+}
+
+struct Bot_Policy_State
+{
+    int planned_piece;
+    bool has_plan;
+    bool pressed;
+    int step;
+    Piece_State expected;
+    Placement plan;
+};
+
+struct Thread_Bot
+{
+    Bot bot;
+    bool ready;
+
+    ~Thread_Bot()
+    {
+        if (ready)
+        {
+            bot_free(&bot);
+        }
+    }
+};
+
+Bot *thread_bot(const Bot_Config *config)
+{
+    static thread_local Thread_Bot thread_bot;
+    if (!thread_bot.ready)
+    {
+        bot_init(&thread_bot.bot, config);
+        thread_bot.ready = true;
+    }
+    thread_bot.bot.config = *config;
+    return &thread_bot.bot;
+}
+
+void bot_policy(const Game_State *game, Input_State *input, void *state, const void *config)
+{
+    Bot_Policy_State *policy = (Bot_Policy_State *)state;
+    input->left = 0;
+    input->right = 0;
+    input->up = 0;
+    input->down = 0;
+    input->a = 0;
+    if (game->phase != GAME_PLAY)
+    {
+        return;
+    }
+    if (policy->planned_piece != game->piece_count)
+    {
+        Bot *bot = thread_bot(config ? (const Bot_Config *)config : &DEFAULT_BOT_CONFIG);
+        policy->planned_piece = game->piece_count;
+        policy->has_plan = bot_choose(bot, game, &policy->plan);
+        policy->pressed = false;
+        policy->step = 0;
+        policy->expected = game->piece;
+    }
+    if (policy->pressed || !policy->has_plan)
+    {
+        policy->pressed = false;
+        return;
+    }
+    while (policy->step < policy->plan.path_length)
+    {
+        u8 move = policy->plan.path[policy->step++];
+        switch (move)
+        {
+        case MOVE_LEFT:
+            input->left = 1;
+            break;
+        case MOVE_RIGHT:
+            input->right = 1;
+            break;
+        case MOVE_ROTATE:
+            input->up = 1;
+            break;
+        case MOVE_DOWN:
+            ++policy->expected.offset_row;
+            if (game->piece.offset_row >= policy->expected.offset_row)
+            {
+                continue;
+            }
+            input->down = 1;
+            break;
+        case MOVE_DROP:
+            input->a = 1;
+            break;
+        }
+        policy->pressed = true;
+        return;
+    }
+}
+
+const Input_Policy BOT_POLICY = { "bot", bot_policy, sizeof(Bot_Policy_State), 0 };
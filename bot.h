@@ -0,0 +1,55 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "batch.h"
+#include "eval.h"
+#include "search.h"
+#include "tt.h"
+
+struct Bot_Weights
+{
+    float height;
+    float lines;
+    float holes;
+    float bumpiness;
+    float wells;
+    float row_transitions;
+};
+
+struct Bot_Config
+{
+    Bot_Weights weights;
+    int depth;
+    Transposition_Table *table;
+};
+
+struct Bot_Ply
+{
+    Placement_List placements;
+    u16 rows[MAX_PLACEMENTS][HEIGHT];
+    u64 hashes[MAX_PLACEMENTS];
+    int lines_cleared[MAX_PLACEMENTS];
+    float values[MAX_PLACEMENTS];
+};
+
+struct Bot
+{
+    Bot_Config config;
+    Bot_Ply plies[2];
+    int misses[MAX_PLACEMENTS];
+    Board_Batch batch;
+    Board_Features features;
+};
+
+extern const Bot_Config DEFAULT_BOT_CONFIG;
+extern const Input_Policy BOT_POLICY;
+
+void bot_init(Bot *bot, const Bot_Config *config);
+void bot_free(Bot *bot);
+// Picks the best placement for the current piece, looking config.depth
+// pieces ahead through the next-piece queue. Board values are cached in
+// config.table, keyed by Zobrist hash, when one is given. Returns false
+// when every placement tops out.
+bool bot_choose(Bot *bot, const Game_State *game, Placement *out);
+
+#endif
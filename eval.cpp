@@ -0,0 +1,143 @@
+#include <new>
+#include <string.h>
+#include "eval_kernel.h"
+
+#define EVAL_ALIGNMENT 32
+
+struct Scalar_Ops
+{
+    typedef u16 V;
+    enum { LANES = 1 };
+
+    static V load(const u16 *p) { return *p; }
+    static void store(u16 *p, V a) { *p = a; }
+    static void store_lines(u32 *p, V low, V high) { *p = low | ((u32)high << 16); }
+    static V set1(int value) { return (u16)value; }
+    static V and_(V a, V b) { return a & b; }
+    static V or_(V a, V b) { return a | b; }
+    static V xor_(V a, V b) { return a ^ b; }
+    static V andnot(V a, V b) { return a & (u16)~b; }
+    static V add(V a, V b) { return (u16)(a + b); }
+    static V sub(V a, V b) { return (u16)(a - b); }
+    static V shl(V a, int count) { return (u16)(a << count); }
+    static V shr(V a, int count) { return (u16)(a >> count); }
+    static V cmpeq(V a, V b) { return a == b ? 0xFFFF : 0; }
+    static V max(V a, V b) { return a > b ? a : b; }
+    static V min(V a, V b) { return a < b ? a : b; }
+};
+
+template <typename T>
+T *eval_alloc(int count)
+{
+    T *result = (T *)::operator new[](count * sizeof(T), std::align_val_t(EVAL_ALIGNMENT));
+    memset(result, 0, count * sizeof(T));
+    return result;
+}
+
+template <typename T>
+void eval_free(T *pointer)
+{
+    ::operator delete[](pointer, std::align_val_t(EVAL_ALIGNMENT));
+}
+
+void board_batch_init(Board_Batch *batch, int capacity)
+{
+    batch->count = 0;
+    batch->capacity = (capacity + EVAL_LANES - 1) / EVAL_LANES * EVAL_LANES;
+    batch->rows = eval_alloc<u16>(batch->capacity * HEIGHT);
+}
+
+void board_batch_free(Board_Batch *batch)
+{
+    eval_free(batch->rows);
+    batch->rows = 0;
+    batch->count = 0;
+    batch->capacity = 0;
+}
+
+int board_batch_add(Board_Batch *batch, const u16 *rows)
+{
+    if (batch->count >= batch->capacity)
+    {
+        return -1;
+    }
+    int index = batch->count++;
+    for (int row = 0;row < HEIGHT;++row)
+    {
+        batch->rows[row * batch->capacity + index] = rows[row];
+    }
+    return index;
+}
+
+void board_batch_get(const Board_Batch *batch, int index, u16 *rows_out)
+{
+    for (int row = 0;row < HEIGHT;++row)
+    {
+        rows_out[row] = batch->rows[row * batch->capacity + index];
+    }
+}
+
+void board_features_init(Board_Features *features, int capacity)
+{
+    capacity = (capacity + EVAL_LANES - 1) / EVAL_LANES * EVAL_LANES;
+    features->capacity = capacity;
+    features->heights = eval_alloc<u16>(capacity * WIDTH);
+    features->wells = eval_alloc<u16>(capacity * WIDTH);
+    features->holes = eval_alloc<u16>(capacity);
+    features->bumpiness = eval_alloc<u16>(capacity);
+    features->row_transitions = eval_alloc<u16>(capacity);
+    features->line_count = eval_alloc<u16>(capacity);
+    features->lines = eval_alloc<u32>(capacity);
+}
+
+void board_features_free(Board_Features *features)
+{
+    eval_free(features->heights);
+    eval_free(features->wells);
+    eval_free(features->holes);
+    eval_free(features->bumpiness);
+    eval_free(features->row_transitions);
+    eval_free(features->line_count);
+    eval_free(features->lines);
+    memset(features, 0, sizeof(*features));
+}
+
+void evaluate_board_batch_scalar(const Board_Batch *batch, Board_Features *features)
+{
+    evaluate_kernel<Scalar_Ops>(batch, features);
+}
+
+Eval_Kernel best_eval_kernel()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    static Eval_Kernel kernel = __builtin_cpu_supports("avx2") ? EVAL_KERNEL_AVX2
+        : __builtin_cpu_supports("sse2") ? EVAL_KERNEL_SSE2
+        : EVAL_KERNEL_SCALAR;
+    return kernel;
+#else
+    return EVAL_KERNEL_SCALAR;
+#endif
+}
+
+void evaluate_board_batch(const Board_Batch *batch, Board_Features *features,
+                          Eval_Kernel kernel)
+{
+    if (kernel == EVAL_KERNEL_AUTO)
+    {
+        kernel = best_eval_kernel();
+    }
+    switch (kernel)
+    {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    case EVAL_KERNEL_AVX2:
+        evaluate_board_batch_avx2(batch, features);
+        break;
+    case EVAL_KERNEL_SSE2:
+        evaluate_board_batch_sse2(batch, features);
+        break;
+#endif
+    default:
+        evaluate_board_batch_scalar(batch, features);
+        break;
+    }
+}
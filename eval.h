@@ -0,0 +1,60 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "game.h"
+
+#define EVAL_LANES 16
+
+enum Eval_Kernel
+{
+    EVAL_KERNEL_AUTO,
+    EVAL_KERNEL_SCALAR,
+    EVAL_KERNEL_SSE2,
+    EVAL_KERNEL_AVX2
+};
+
+// Candidate boards stored as occupancy rows, one row of every board after
+// another: rows[row * capacity + board]. capacity is a multiple of
+// EVAL_LANES so the vector kernels never need a tail loop.
+struct Board_Batch
+{
+    int count;
+    int capacity;
+    u16 *rows;
+};
+
+// Features per board, laid out the same way as Board_Batch. heights and
+// wells are per column: heights[col * capacity + board]. A well cell is an
+// open cell above the column's surface with both neighbours filled (walls
+// count as filled). Row transitions count filled/empty changes along each
+// row with the walls treated as filled. lines has bit row set for every
+// filled row, as find_lines would report.
+struct Board_Features
+{
+    int capacity;
+    u16 *heights;
+    u16 *wells;
+    u16 *holes;
+    u16 *bumpiness;
+    u16 *row_transitions;
+    u16 *line_count;
+    u32 *lines;
+};
+
+void board_batch_init(Board_Batch *batch, int capacity);
+void board_batch_free(Board_Batch *batch);
+int board_batch_add(Board_Batch *batch, const u16 *rows);
+void board_batch_get(const Board_Batch *batch, int index, u16 *rows_out);
+
+void board_features_init(Board_Features *features, int capacity);
+void board_features_free(Board_Features *features);
+
+Eval_Kernel best_eval_kernel();
+void evaluate_board_batch(const Board_Batch *batch, Board_Features *features,
+                          Eval_Kernel kernel = EVAL_KERNEL_AUTO);
+
+void evaluate_board_batch_scalar(const Board_Batch *batch, Board_Features *features);
+void evaluate_board_batch_sse2(const Board_Batch *batch, Board_Features *features);
+void evaluate_board_batch_avx2(const Board_Batch *batch, Board_Features *features);
+
+#endif
@@ -0,0 +1,40 @@
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#pragma GCC target("avx2")
+#include <immintrin.h>
+#include "eval_kernel.h"
+
+struct Avx2_Ops
+{
+    typedef __m256i V;
+    enum { LANES = 16 };
+
+    static V load(const u16 *p) { return _mm256_loadu_si256((const __m256i *)p); }
+    static void store(u16 *p, V a) { _mm256_storeu_si256((__m256i *)p, a); }
+    static void store_lines(u32 *p, V low, V high)
+    {
+        V first = _mm256_unpacklo_epi16(low, high);
+        V second = _mm256_unpackhi_epi16(low, high);
+        _mm256_storeu_si256((__m256i *)p, _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256((__m256i *)(p + 8), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    static V set1(int value) { return _mm256_set1_epi16((short)value); }
+    static V and_(V a, V b) { return _mm256_and_si256(a, b); }
+    static V or_(V a, V b) { return _mm256_or_si256(a, b); }
+    static V xor_(V a, V b) { return _mm256_xor_si256(a, b); }
+    static V andnot(V a, V b) { return _mm256_andnot_si256(b, a); }
+    static V add(V a, V b) { return _mm256_add_epi16(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_epi16(a, b); }
+    static V shl(V a, int count) { return _mm256_sll_epi16(a, _mm_cvtsi32_si128(count)); }
+    static V shr(V a, int count) { return _mm256_srl_epi16(a, _mm_cvtsi32_si128(count)); }
+    static V cmpeq(V a, V b) { return _mm256_cmpeq_epi16(a, b); }
+    static V max(V a, V b) { return _mm256_max_epi16(a, b); }
+    static V min(V a, V b) { return _mm256_min_epi16(a, b); }
+};
+
+void evaluate_board_batch_avx2(const Board_Batch *batch, Board_Features *features)
+{
+    evaluate_kernel<Avx2_Ops>(batch, features);
+}
+
+#endif
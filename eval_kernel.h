@@ -0,0 +1,101 @@
+#ifndef EVAL_KERNEL_H
+#define EVAL_KERNEL_H
+
+#include "eval.h"
+
+// Shared body of every evaluator kernel. Ops wraps one vector of 16-bit
+// lanes (a plain u16 for the scalar kernel), so all kernels run the exact
+// same sequence of lane operations and produce identical features.
+// Only include this from the kernel translation units: they are compiled
+// for different instruction sets.
+
+template <typename Ops>
+inline typename Ops::V popcount16(typename Ops::V x)
+{
+    x = Ops::sub(x, Ops::and_(Ops::shr(x, 1), Ops::set1(0x5555)));
+    x = Ops::add(Ops::and_(x, Ops::set1(0x3333)),
+                 Ops::and_(Ops::shr(x, 2), Ops::set1(0x3333)));
+    x = Ops::and_(Ops::add(x, Ops::shr(x, 4)), Ops::set1(0x0F0F));
+    return Ops::and_(Ops::add(x, Ops::shr(x, 8)), Ops::set1(0x001F));
+}
+
+template <typename Ops>
+void evaluate_kernel(const Board_Batch *batch, Board_Features *features)
+{
+    typedef typename Ops::V V;
+    const int capacity = batch->capacity;
+    const V one = Ops::set1(1);
+    const V full = Ops::set1((1 << WIDTH) - 1);
+    const V walls = Ops::set1((1 << (WIDTH + 1)) - 1);
+    const V right_wall = Ops::set1(1 << WIDTH);
+    const V last_col = Ops::set1(1 << (WIDTH - 1));
+
+    for (int board = 0;board < batch->count;board += Ops::LANES)
+    {
+        V seen = Ops::set1(0);
+        V holes = Ops::set1(0);
+        V transitions = Ops::set1(0);
+        V line_count = Ops::set1(0);
+        V lines_low = Ops::set1(0);
+        V lines_high = Ops::set1(0);
+        V heights[WIDTH];
+        V wells[WIDTH];
+        for (int col = 0;col < WIDTH;++col)
+        {
+            heights[col] = Ops::set1(0);
+            wells[col] = Ops::set1(0);
+        }
+
+        for (int row = 0;row < HEIGHT;++row)
+        {
+            V r = Ops::load(batch->rows + row * capacity + board);
+            seen = Ops::or_(seen, r);
+            holes = Ops::add(holes, popcount16<Ops>(Ops::andnot(seen, r)));
+
+            V walled = Ops::or_(r, right_wall);
+            V changes = Ops::xor_(walled, Ops::or_(Ops::shl(walled, 1), one));
+            transitions = Ops::add(transitions, popcount16<Ops>(Ops::and_(changes, walls)));
+
+            V left_filled = Ops::or_(Ops::shl(r, 1), one);
+            V right_filled = Ops::or_(Ops::shr(r, 1), last_col);
+            V well = Ops::and_(Ops::andnot(full, seen), Ops::and_(left_filled, right_filled));
+
+            for (int col = 0;col < WIDTH;++col)
+            {
+                heights[col] = Ops::add(heights[col], Ops::and_(Ops::shr(seen, col), one));
+                wells[col] = Ops::add(wells[col], Ops::and_(Ops::shr(well, col), one));
+            }
+
+            V filled = Ops::cmpeq(r, full);
+            line_count = Ops::sub(line_count, filled);
+            if (row < 16)
+            {
+                lines_low = Ops::or_(lines_low, Ops::and_(filled, Ops::set1(1 << row)));
+            }
+            else
+            {
+                lines_high = Ops::or_(lines_high, Ops::and_(filled, Ops::set1(1 << (row - 16))));
+            }
+        }
+
+        V bumpiness = Ops::set1(0);
+        for (int col = 0;col < WIDTH;++col)
+        {
+            Ops::store(features->heights + col * capacity + board, heights[col]);
+            Ops::store(features->wells + col * capacity + board, wells[col]);
+            if (col + 1 < WIDTH)
+            {
+                V a = heights[col];
+                V b = heights[col + 1];
+                bumpiness = Ops::add(bumpiness, Ops::sub(Ops::max(a, b), Ops::min(a, b)));
+            }
+        }
+        Ops::store(features->holes + board, holes);
+        Ops::store(features->bumpiness + board, bumpiness);
+        Ops::store(features->row_transitions + board, transitions);
+        Ops::store(features->line_count + board, line_count);
+        Ops::store_lines(features->lines + board, lines_low, lines_high);
+    }
+}
+
+#endif
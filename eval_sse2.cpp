@@ -0,0 +1,38 @@
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#pragma GCC target("sse2")
+#include <emmintrin.h>
+#include "eval_kernel.h"
+
+struct Sse2_Ops
+{
+    typedef __m128i V;
+    enum { LANES = 8 };
+
+    static V load(const u16 *p) { return _mm_loadu_si128((const __m128i *)p); }
+    static void store(u16 *p, V a) { _mm_storeu_si128((__m128i *)p, a); }
+    static void store_lines(u32 *p, V low, V high)
+    {
+        _mm_storeu_si128((__m128i *)p, _mm_unpacklo_epi16(low, high));
+        _mm_storeu_si128((__m128i *)(p + 4), _mm_unpackhi_epi16(low, high));
+    }
+    static V set1(int value) { return _mm_set1_epi16((short)value); }
+    static V and_(V a, V b) { return _mm_and_si128(a, b); }
+    static V or_(V a, V b) { return _mm_or_si128(a, b); }
+    static V xor_(V a, V b) { return _mm_xor_si128(a, b); }
+    static V andnot(V a, V b) { return _mm_andnot_si128(b, a); }
+    static V add(V a, V b) { return _mm_add_epi16(a, b); }
+    static V sub(V a, V b) { return _mm_sub_epi16(a, b); }
+    static V shl(V a, int count) { return _mm_sll_epi16(a, _mm_cvtsi32_si128(count)); }
+    static V shr(V a, int count) { return _mm_srl_epi16(a, _mm_cvtsi32_si128(count)); }
+    static V cmpeq(V a, V b) { return _mm_cmpeq_epi16(a, b); }
+    static V max(V a, V b) { return _mm_max_epi16(a, b); }
+    static V min(V a, V b) { return _mm_min_epi16(a, b); }
+};
+
+void evaluate_board_batch_sse2(const Board_Batch *batch, Board_Features *features)
+{
+    evaluate_kernel<Sse2_Ops>(batch, features);
+}
+
+#endif
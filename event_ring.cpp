@@ -0,0 +1,174 @@
+#include <string.h>
+#include "event_ring.h"
+
+const u32 EVENT_TYPES[] = {
+    GAME_EVENT_GAME_START,
+    GAME_EVENT_PIECE_LOCK,
+    GAME_EVENT_LINE_CLEAR,
+    GAME_EVENT_LEVEL_UP,
+    GAME_EVENT_GAME_OVER
+};
+
+void event_ring_init(Event_Ring *ring, u32 capacity)
+{
+    u64 count = 1;
+    while (count < capacity)
+    {
+        count *= 2;
+    }
+    ring->slots = new Event_Slot[count];
+    ring->mask = count - 1;
+    for (u64 i = 0;i < count;++i)
+    {
+        ring->slots[i].sequence.store(0, std::memory_order_relaxed);
+    }
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->closed.store(false, std::memory_order_relaxed);
+    ring->waiters.store(0, std::memory_order_relaxed);
+}
+
+void event_ring_free(Event_Ring *ring)
+{
+    delete[] ring->slots;
+    ring->slots = 0;
+    ring->mask = 0;
+}
+
+// Callers store head or closed seq_cst first. A waiter counts itself in and
+// then checks both, also seq_cst, so either it sees the new value or this
+// sees the waiter.
+inline void wake_waiters(Event_Ring *ring)
+{
+    if (ring->waiters.load(std::memory_order_seq_cst) == 0)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(ring->wait_lock);
+    ring->wake.notify_all();
+}
+
+void event_ring_push(Event_Ring *ring, const Event_Record *record)
+{
+    u64 head = ring->head.load(std::memory_order_relaxed);
+    Event_Slot *slot = ring->slots + (head & ring->mask);
+    u32 words[EVENT_RECORD_WORDS];
+    memcpy(words, record, sizeof(words));
+
+    slot->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (u32 i = 0;i < EVENT_RECORD_WORDS;++i)
+    {
+        slot->words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot->sequence.store(head + 1, std::memory_order_release);
+    ring->head.store(head + 1, std::memory_order_seq_cst);
+    wake_waiters(ring);
+}
+
+void event_ring_publish(Event_Ring *ring, const Game_State *game)
+{
+    if (!game->events)
+    {
+        return;
+    }
+    Event_Record record = {};
+    record.tick = (u32)game->time;
+    record.level = (u16)game->level;
+    record.start_level = (u16)game->start_level;
+    record.points = game->points;
+    record.line_count = game->line_count;
+    record.piece_count = (u32)game->piece_count;
+    for (u32 type : EVENT_TYPES)
+    {
+        if (!(game->events & type))
+        {
+            continue;
+        }
+        record.type = (u8)type;
+        record.cleared_count = 0;
+        record.cleared_rows = 0;
+        if (type == GAME_EVENT_LINE_CLEAR)
+        {
+            record.cleared_count = (u8)game->pending_line_count;
+            for (int row = 0;row < HEIGHT;++row)
+            {
+                record.cleared_rows |= (u32)(game->lines[row] != 0) << row;
+            }
+        }
+        event_ring_push(ring, &record);
+    }
+}
+
+void event_ring_close(Event_Ring *ring)
+{
+    ring->closed.store(true, std::memory_order_seq_cst);
+    wake_waiters(ring);
+}
+
+void event_cursor_init(const Event_Ring *ring, Event_Cursor *cursor)
+{
+    cursor->next = ring->head.load(std::memory_order_acquire);
+    cursor->dropped = 0;
+}
+
+bool event_ring_pop(const Event_Ring *ring, Event_Cursor *cursor, Event_Record *record)
+{
+    u64 capacity = ring->mask + 1;
+    for (;;)
+    {
+        u64 head = ring->head.load(std::memory_order_acquire);
+        if (cursor->next == head)
+        {
+            return false;
+        }
+        if (head - cursor->next > capacity)
+        {
+            cursor->dropped += head - capacity - cursor->next;
+            cursor->next = head - capacity;
+        }
+        const Event_Slot *slot = ring->slots + (cursor->next & ring->mask);
+        u32 words[EVENT_RECORD_WORDS];
+        u64 before = slot->sequence.load(std::memory_order_acquire);
+        for (u32 i = 0;i < EVENT_RECORD_WORDS;++i)
+        {
+            words[i] = slot->words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        u64 after = slot->sequence.load(std::memory_order_relaxed);
+        if (before == cursor->next + 1 && after == before)
+        {
+            memcpy(record, words, sizeof(words));
+            ++cursor->next;
+            return true;
+        }
+        // The producer lapped this cursor while it was reading.
+        ++cursor->dropped;
+        ++cursor->next;
+    }
+}
+
+bool event_ring_wait(Event_Ring *ring, Event_Cursor *cursor, Event_Record *record)
+{
+    for (;;)
+    {
+        bool closed = ring->closed.load(std::memory_order_acquire);
+        if (event_ring_pop(ring, cursor, record))
+        {
+            return true;
+        }
+        if (closed)
+        {
+            return false;
+        }
+        ring->waiters.fetch_add(1, std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(ring->wait_lock);
+            ring->wake.wait(lock, [ring, cursor]()
+            {
+                return ring->head.load(std::memory_order_seq_cst) != cursor->next ||
+                       ring->closed.load(std::memory_order_seq_cst);
+            });
+        }
+        ring->waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include "game.h"
+
+#define EVENT_RING_CAPACITY 1024
+
+// One game event. Everything but type and tick is the state right after it.
+struct Event_Record
+{
+    u32 tick;
+    u8 type;
+    // Line clears only: how many rows went and which, bit r for row r.
+    u8 cleared_count;
+    u16 level;
+    u32 cleared_rows;
+    u16 start_level;
+    u16 reserved;
+    int points;
+    int line_count;
+    u32 piece_count;
+    u32 reserved2;
+};
+
+#define EVENT_RECORD_WORDS (sizeof(Event_Record) / sizeof(u32))
+
+static_assert(sizeof(Event_Record) == 32, "event record layout");
+
+// The record is written a word at a time between two stores of sequence:
+// 0 while it is being written and the event number plus one once it is
+// done. A reader that finds the same number before and after copying the
+// words got the whole record; anything else means the slot was reused.
+struct alignas(64) Event_Slot
+{
+    std::atomic<u64> sequence;
+    std::atomic<u32> words[EVENT_RECORD_WORDS];
+};
+
+// Single producer, any number of consumers, each of which sees every event.
+// The producer never waits: a consumer that falls a whole ring behind loses
+// the oldest events it has not read and is told how many. Reading takes no
+// lock. Consumers with nothing to read sleep on wake, and the producer only
+// takes wait_lock to notify when waiters says someone is asleep.
+struct Event_Ring
+{
+    Event_Slot *slots;
+    u64 mask;
+    alignas(64) std::atomic<u64> head;
+    std::atomic<bool> closed;
+    alignas(64) std::atomic<u32> waiters;
+    std::mutex wait_lock;
+    std::condition_variable wake;
+};
+
+// Owned by one consumer thread.
+struct Event_Cursor
+{
+    u64 next;
+    u64 dropped;
+};
+
+// capacity is rounded up to a power of two.
+void event_ring_init(Event_Ring *ring, u32 capacity);
+void event_ring_free(Event_Ring *ring);
+void event_ring_push(Event_Ring *ring, const Event_Record *record);
+// Pushes a record for each flag in game->events, in flag order.
+void event_ring_publish(Event_Ring *ring, const Game_State *game);
+// Consumers drain what is left and then stop waiting.
+void event_ring_close(Event_Ring *ring);
+
+// Starts at the next event pushed.
+void event_cursor_init(const Event_Ring *ring, Event_Cursor *cursor);
+// Returns false when the cursor has caught up.
+bool event_ring_pop(const Event_Ring *ring, Event_Cursor *cursor, Event_Record *record);
+// Sleeps until there is an event. Returns false once the ring is closed and
+// the cursor has caught up.
+bool event_ring_wait(Event_Ring *ring, Event_Cursor *cursor, Event_Record *record);
+
+#endif
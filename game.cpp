@@ -0,0 +1,316 @@
+#include <string.h>
+#include "game.h"
+#include "profile.h"
+
+inline u8 check_row_empty(const Game_Board::Row *rows, int row)
+{
+    return rows[row] == 0;
+}
+
+inline bool piece_fits(const Game_State *game, const Piece_State *piece)
+{
+    PROFILE_CORE_COUNT(PROFILE_COUNTER_CHECK_PIECE_VALID);
+    return check_piece_valid<WIDTH, HEIGHT>(piece, game->board.rows);
+}
+
+void merge_piece(Game_State *game)
+{
+    const Tetrino_Shape *shape = tetrino_shape(game->piece.tetrino_index, game->piece.rotation);
+    for (int cell = 0;cell < 4;++cell)
+    {
+        int board_row = game->piece.offset_row + shape->cell_row[cell];
+        int board_col = game->piece.offset_col + shape->cell_col[cell];
+        matrix_set(game->board.cells, WIDTH, board_row, board_col, shape->value);
+        game->board.rows[board_row] |= (Game_Board::Row)1 << board_col;
+        game->board.columns[board_col] |= (Game_Board::Column)1 << board_row;
+        game->board_hash ^= ZOBRIST.cells[board_row][board_col];
+    }
+}
+u8 next_tetrino(Game_State *game)
+{
+    int count = ARRAY_COUNT(KHOIGACH);
+    if (game->randomizer == RANDOMIZER_UNIFORM)
+    {
+        return (u8)rng_range(&game->rng, count);
+    }
+    if (game->bag_count == 0)
+    {
+        for (int i = 0;i < count;++i)
+        {
+            game->bag[i] = (u8)i;
+        }
+        game->bag_count = count;
+    }
+    int pick = rng_range(&game->rng, game->bag_count);
+    u8 result = game->bag[pick];
+    game->bag[pick] = game->bag[--game->bag_count];
+    return result;
+}
+inline int get_time_to_next_drop(int level)
+{
+    if (level >= (int)ARRAY_COUNT(CONST_LEVEL))
+    {
+        level = ARRAY_COUNT(CONST_LEVEL) - 1;
+    }
+    return CONST_LEVEL[level];
+}
+
+inline void update_landing_row(Game_State *game)
+{
+    PROFILE_CORE_COUNT(PROFILE_COUNTER_LANDING_ROW);
+    game->landing_row = game->piece.offset_row +
+        drop_distance<WIDTH, HEIGHT>(&game->piece, game->board.columns);
+}
+
+void spawn_piece(Game_State *game)
+{
+    game->piece = {};
+    game->piece.tetrino_index = game->next_pieces[0];
+    memmove(game->next_pieces, game->next_pieces + 1, NEXT_PIECE_COUNT - 1);
+    game->next_pieces[NEXT_PIECE_COUNT - 1] = next_tetrino(game);
+    ++game->piece_count;
+    game->piece.offset_col = WIDTH / 2;
+    game->next_drop_time = game->time + get_time_to_next_drop(game->level);
+    update_landing_row(game);
+}
+
+void game_init(Game_State *game, u64 seed, Randomizer randomizer)
+{
+    memset(game, 0, sizeof(*game));
+    game->seed = seed;
+    game->randomizer = randomizer;
+    rng_seed(&game->rng, seed);
+    for (int i = 0;i < NEXT_PIECE_COUNT;++i)
+    {
+        game->next_pieces[i] = next_tetrino(game);
+    }
+    spawn_piece(game);
+}
+
+inline bool soft_drop(Game_State *game)
+{
+    if (game->piece.offset_row >= game->landing_row)
+    {
+        merge_piece(game);
+        game->events |= GAME_EVENT_PIECE_LOCK;
+        spawn_piece(game);
+        return false;
+    }
+    ++game->piece.offset_row;
+    game->next_drop_time = game->time + get_time_to_next_drop(game->level);
+    return true;
+}
+
+int count_points(int level, int line_count)
+{
+    switch (line_count)
+    {
+    case 1:
+        return 50 * (level + 1);
+    case 2:
+        return 100 * (level + 1);
+    case 3:
+        return 400 * (level + 1);
+    case 4:
+        return 1000 * (level + 1);
+    }
+    return 0;
+}
+
+inline int min(int x, int y)
+{
+    return x < y ? x : y;
+}
+inline int max(int x, int y)
+{
+    return x > y ? x : y;
+}
+inline int get_lines_for_next_level(int start_level, int level)
+{
+    int first_level_up_limit = min((start_level * 10 + 10),max(100, (start_level * 10 - 50)));
+
+    if (level == start_level)
+    {
+        return first_level_up_limit;
+    }
+    int diff = level - start_level;
+    return first_level_up_limit + diff * 10;
+}
+
+void game_begin(Game_State *game, int start_level)
+{
+    if(game->score < game->points)
+    {
+        game->score=game->points;
+    }
+    board_clear(&game->board);
+    game->board_hash = 0;
+    game->start_level = start_level;
+    game->level = start_level;
+    game->line_count = 0;
+    game->points = 0;
+    spawn_piece(game);
+    game->phase = GAME_PLAY;
+    game->events |= GAME_EVENT_GAME_START;
+}
+
+void game_start(Game_State *game, const Input_State *input)
+{
+    if (input->dup > 0)
+    {
+        ++game->start_level;
+    }
+    if (input->ddown > 0 && game->start_level > 0)
+    {
+        --game->start_level;
+    }
+    if (input->da > 0)
+    {
+        game_begin(game, game->start_level);
+    }
+}
+void update_game_gameover(Game_State *game, const Input_State *input)
+{
+    if (input->da > 0)
+    {
+        game->phase = GAME_START;
+    }
+}
+void update_game_line(Game_State *game)
+{
+    if (game->time >= game->highlight)
+    {
+        clear_lines<WIDTH, HEIGHT>(game->board.cells, game->board.rows, game->lines,
+                                   &game->board_hash);
+        build_columns<WIDTH, HEIGHT>(game->board.rows, game->board.columns);
+        update_landing_row(game);
+        game->events |= GAME_EVENT_LINE_CLEAR;
+        game->line_count += game->pending_line_count;
+        game->points += count_points(game->level, game->pending_line_count);
+
+        int lines_for_next_level = get_lines_for_next_level(game->start_level, game->level);
+
+        if (game->line_count >= lines_for_next_level)
+        {
+            ++game->level;
+            game->events |= GAME_EVENT_LEVEL_UP;
+        }
+        game->phase = GAME_PLAY;
+    }
+}
+void auto_shift(Game_State *game, const Input_State *input)
+{
+    if (input->dleft > 0 || input->dright > 0)
+    {
+        game->shift_direction = input->dright > 0 ? 1 : -1;
+        game->shift_time = game->time + game->das;
+        return;
+    }
+    if ((game->shift_direction < 0 && !input->left) ||
+        (game->shift_direction > 0 && !input->right))
+    {
+        game->shift_direction = 0;
+    }
+    if (game->shift_direction == 0 || game->time < game->shift_time)
+    {
+        return;
+    }
+    Piece_State piece = game->piece;
+    do
+    {
+        piece.offset_col += game->shift_direction;
+        if (!piece_fits(game, &piece))
+        {
+            break;
+        }
+        game->piece = piece;
+    } while (game->arr == 0);
+    update_landing_row(game);
+    game->shift_time = game->time + game->arr;
+}
+void game_play(Game_State *game , const Input_State *input)
+{
+    Piece_State piece = game->piece;
+    if (input->dleft > 0)
+    {
+        --piece.offset_col;
+    }
+    if (input->dright> 0)
+    {
+        ++piece.offset_col;
+    }
+    if (input->dup > 0)
+    {
+        piece.rotation = (piece.rotation + 1) % 4;
+    }
+    bool moved = input->dleft > 0 || input->dright > 0 || input->dup > 0;
+    if (moved && piece_fits(game, &piece))
+    {
+        game->piece = piece;
+        update_landing_row(game);
+    }
+    if (game->das > 0)
+    {
+        auto_shift(game, input);
+    }
+    if (input->ddown > 0)
+    {
+        soft_drop(game);
+    }
+    if (input->da > 0)
+    {
+        game->piece.offset_row = game->landing_row;
+        soft_drop(game);
+    }
+    while (game->time >= game->next_drop_time)
+    {
+        soft_drop(game);
+    }
+    game->pending_line_count = find_lines<WIDTH, HEIGHT>(game->board.rows, game->lines);
+    if (game->pending_line_count > 0)
+    {
+        game->phase = GAME_LINE;
+        game->highlight = game->time + TICKS_PER_SECOND / 2;
+    }
+    int game_over_row = 0;
+    if (!check_row_empty(game->board.rows, game_over_row))
+    {
+        game->phase = GAME_GAMEOVER;
+        game->events |= GAME_EVENT_GAME_OVER;
+    }
+}
+void update_game(Game_State *game , const Input_State *input)
+{
+    ++game->time;
+    game->events = 0;
+    switch(game->phase)
+    {
+    case GAME_START:
+        game_start(game, input);
+        break;
+    case GAME_PLAY:
+        game_play(game, input);
+        break;
+    case GAME_LINE:
+        update_game_line(game);
+        break;
+    case GAME_GAMEOVER:
+        update_game_gameover(game, input);
+        break;
+    }
+}
+
+// The game only plays WIDTH by HEIGHT. tetris_bench runs and checks the board
+// kernels at these sizes too, covering the u16 rows with u32 columns and the
+// u64 rows and columns.
+#define INSTANTIATE_BOARD(W, H) \
+    template struct Board<W, H>; \
+    template void build_columns<W, H>(const Bit_Row<W> *, Bit_Row<H + 1> *); \
+    template int drop_distance<W, H>(const Piece_State *, const Bit_Row<H + 1> *); \
+    template int find_lines<W, H>(const Bit_Row<W> *, u8 *); \
+    template void clear_lines<W, H>(u8 *, Bit_Row<W> *, const u8 *, u64 *); \
+    template bool check_piece_valid<W, H>(const Piece_State *, const Bit_Row<W> *); \
+    template void board_clear<W, H>(Board<W, H> *);
+
+INSTANTIATE_BOARD(4, 20)
+INSTANTIATE_BOARD(40, 60)
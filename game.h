@@ -0,0 +1,634 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+#define WIDTH 10
+#define HEIGHT 22
+#define REAL_HEIGHT 20
+#define ARRAY_COUNT(x) (sizeof(x) / sizeof((x)[0]))
+
+#define TICKS_PER_SECOND 60
+#define NEXT_PIECE_COUNT 5
+#define DEFAULT_DAS 16
+#define DEFAULT_ARR 6
+
+const u8 CONST_LEVEL[] = {45,40,35,30,25,20,15,10,8,6,5,4,3,2,1};
+
+struct Khoigach
+{
+    const u8 *data;
+    const int side;
+};
+
+constexpr Khoigach khoigach(const u8 *data, int side)
+{
+    return { data, side };
+}
+
+constexpr u8 KHOI_I[] = {
+    0, 0, 0, 0,
+    1, 1, 1, 1,
+    0, 0, 0, 0,
+    0, 0, 0, 0
+};
+
+constexpr u8 KHOI_O[] = {
+    2, 2,
+    2, 2
+};
+
+constexpr u8 KHOI_T[] = {
+    0, 0, 0,
+    3, 3, 3,
+    0, 3, 0
+};
+
+constexpr u8 KHOI_S[] = {
+    0, 4, 4,
+    4, 4, 0,
+    0, 0, 0
+};
+
+constexpr u8 KHOI_Z[] = {
+    5, 5, 0,
+    0, 5, 5,
+    0, 0, 0
+};
+
+constexpr u8 KHOI_L[] = {
+    6, 0, 0,
+    6, 6, 6,
+    0, 0, 0
+};
+
+constexpr u8 KHOI_J[] = {
+    0, 0, 7,
+    7, 7, 7,
+    0, 0, 0
+};
+
+
+constexpr Khoigach KHOIGACH[] = {
+    khoigach(KHOI_I, 4),
+    khoigach(KHOI_O, 2),
+    khoigach(KHOI_T, 3),
+    khoigach(KHOI_S, 3),
+    khoigach(KHOI_Z, 3),
+    khoigach(KHOI_L, 3),
+    khoigach(KHOI_J, 3),
+};
+
+enum Game_Phase
+{
+    GAME_START,
+    GAME_PLAY,
+    GAME_LINE,
+    GAME_GAMEOVER
+};
+
+enum Game_Event
+{
+    GAME_EVENT_PIECE_LOCK = 1 << 0,
+    GAME_EVENT_LINE_CLEAR = 1 << 1,
+    GAME_EVENT_LEVEL_UP = 1 << 2,
+    GAME_EVENT_GAME_OVER = 1 << 3,
+    GAME_EVENT_GAME_START = 1 << 4
+};
+enum Randomizer
+{
+    RANDOMIZER_UNIFORM,
+    RANDOMIZER_BAG
+};
+
+struct Rng
+{
+    u64 state[4];
+};
+
+// Smallest of u16, u32 and u64 with a bit for each of n cells.
+template <int N>
+using Bit_Row = typename std::conditional<(N <= 16), u16,
+    typename std::conditional<(N <= 32), u32, u64>::type>::type;
+
+// Settled cells of a W by H board. rows[row] has bit col set and
+// columns[col] has bit row set when cell (row, col) is filled. Columns get a
+// spare bit for the floor. The board functions below are templates on the
+// size, so every size gets its own unrolled code with the narrowest rows.
+template <int W, int H>
+struct Board
+{
+    static_assert(W >= 1 && W <= 64 && H >= 1 && H <= 63, "unsupported board size");
+    typedef Bit_Row<W> Row;
+    typedef Bit_Row<H + 1> Column;
+    static constexpr int width = W;
+    static constexpr int height = H;
+    static constexpr Row FULL_ROW = (Row)(~0ull >> (64 - W));
+
+    u8 cells[W * H];
+    Row rows[H];
+    Column columns[W];
+};
+
+typedef Board<WIDTH, HEIGHT> Game_Board;
+
+struct Piece_State
+{
+    u8 tetrino_index;
+    int offset_row;
+    int offset_col;
+    int rotation;
+    int tmp;
+};
+struct Game_State
+{
+    Game_Board board;
+    u64 board_hash;
+    u8 lines[HEIGHT];
+    int pending_line_count;
+    Piece_State piece;
+    int landing_row;
+    Game_Phase phase;
+    int start_level;
+    int level;
+    int line_count;
+    int points,score;
+    int next_drop_time;
+    // Delayed auto-shift and auto-repeat rate in ticks. das <= 0 turns
+    // auto-shift off and arr 0 shifts straight to the wall.
+    int das;
+    int arr;
+    int shift_direction;
+    int shift_time;
+    int highlight;
+    int time;
+    u32 events;
+    u64 seed;
+    Rng rng;
+    Randomizer randomizer;
+    u8 bag[ARRAY_COUNT(KHOIGACH)];
+    int bag_count;
+    u8 next_pieces[NEXT_PIECE_COUNT];
+    int piece_count;
+};
+
+struct Input_State
+{
+    u8 left,right,up,down,a;
+    int dleft,dright,dup,ddown,da;
+};
+
+inline void input_update_edges(Input_State *input, const Input_State *prev)
+{
+    input->dleft = input->left - prev->left;
+    input->dright = input->right - prev->right;
+    input->dup = input->up - prev->up;
+    input->ddown = input->down - prev->down;
+    input->da = input->a - prev->a;
+}
+
+inline void input_clear_edges(Input_State *input)
+{
+    input->dleft = 0;
+    input->dright = 0;
+    input->dup = 0;
+    input->ddown = 0;
+    input->da = 0;
+}
+
+enum Input_Key
+{
+    INPUT_KEY_LEFT = 1 << 0,
+    INPUT_KEY_RIGHT = 1 << 1,
+    INPUT_KEY_UP = 1 << 2,
+    INPUT_KEY_DOWN = 1 << 3,
+    INPUT_KEY_A = 1 << 4
+};
+
+inline u8 input_held_keys(const Input_State *input)
+{
+    return (u8)((input->left ? INPUT_KEY_LEFT : 0)
+                | (input->right ? INPUT_KEY_RIGHT : 0)
+                | (input->up ? INPUT_KEY_UP : 0)
+                | (input->down ? INPUT_KEY_DOWN : 0)
+                | (input->a ? INPUT_KEY_A : 0));
+}
+
+inline u8 input_pressed_keys(const Input_State *input)
+{
+    return (u8)((input->dleft > 0 ? INPUT_KEY_LEFT : 0)
+                | (input->dright > 0 ? INPUT_KEY_RIGHT : 0)
+                | (input->dup > 0 ? INPUT_KEY_UP : 0)
+                | (input->ddown > 0 ? INPUT_KEY_DOWN : 0)
+                | (input->da > 0 ? INPUT_KEY_A : 0));
+}
+
+inline int input_key_edge(u8 key, u8 held, u8 prev_held, u8 pressed)
+{
+    if ((pressed | (held & ~prev_held)) & key)
+    {
+        return 1;
+    }
+    return (prev_held & ~held) & key ? -1 : 0;
+}
+
+// Sets the input for one tick from the keys held at its end. Keys in pressed
+// count as pressed this tick even if they were released again before it ended.
+inline void input_set_keys(Input_State *input, u8 held, u8 prev_held, u8 pressed)
+{
+    input->left = (held & INPUT_KEY_LEFT) != 0;
+    input->right = (held & INPUT_KEY_RIGHT) != 0;
+    input->up = (held & INPUT_KEY_UP) != 0;
+    input->down = (held & INPUT_KEY_DOWN) != 0;
+    input->a = (held & INPUT_KEY_A) != 0;
+    input->dleft = input_key_edge(INPUT_KEY_LEFT, held, prev_held, pressed);
+    input->dright = input_key_edge(INPUT_KEY_RIGHT, held, prev_held, pressed);
+    input->dup = input_key_edge(INPUT_KEY_UP, held, prev_held, pressed);
+    input->ddown = input_key_edge(INPUT_KEY_DOWN, held, prev_held, pressed);
+    input->da = input_key_edge(INPUT_KEY_A, held, prev_held, pressed);
+}
+
+inline u64 rng_rotl(u64 x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+inline u64 rng_next(Rng *rng)
+{
+    u64 *s = rng->state;
+    u64 result = rng_rotl(s[1] * 5, 7) * 9;
+    u64 t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return result;
+}
+
+inline u32 rng_range(Rng *rng, u32 range)
+{
+    return (u32)(((rng_next(rng) >> 32) * range) >> 32);
+}
+
+inline void rng_seed(Rng *rng, u64 seed)
+{
+    for (int i = 0;i < 4;++i)
+    {
+        seed += 0x9E3779B97F4A7C15ull;
+        u64 z = seed;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        rng->state[i] = z ^ (z >> 31);
+    }
+}
+
+#define FNV_OFFSET 2166136261u
+
+inline u32 fnv1a(u32 hash, const u8 *data, size_t size)
+{
+    for (size_t i = 0;i < size;++i)
+    {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+inline u8 matrix_get(const u8 *values, int width, int row, int col)
+{
+    int index = row * width + col;
+    return values[index];
+}
+
+inline void matrix_set(u8 *values, int width, int row, int col, u8 value)
+{
+    int index = row * width + col;
+    values[index] = value;
+}
+
+constexpr u8 tetrino_get(const Khoigach *khoigach, int row, int col, int rotation)
+{
+    int side = khoigach->side;
+    switch (rotation)
+    {
+    case 0:
+        return khoigach->data[row * side + col];
+    case 1:
+        return khoigach->data[(side - col - 1) * side + row];
+    case 2:
+        return khoigach->data[(side - row - 1) * side + (side - col - 1)];
+    case 3:
+        return khoigach->data[col * side + (side - row - 1)];
+    }
+    return 0;
+}
+
+struct Tetrino_Shape
+{
+    u8 value;
+    u8 cell_row[4];
+    u8 cell_col[4];
+    u16 row_masks[4];
+    u8 column_top[4];
+    u8 column_bottom[4];
+    int min_row, max_row;
+    int min_col, max_col;
+};
+
+struct Tetrino_Shapes
+{
+    Tetrino_Shape shapes[ARRAY_COUNT(KHOIGACH)][4];
+};
+
+constexpr Tetrino_Shape make_tetrino_shape(const Khoigach *khoigach, int rotation)
+{
+    Tetrino_Shape shape = {};
+    shape.min_row = khoigach->side;
+    shape.min_col = khoigach->side;
+    shape.max_row = -1;
+    shape.max_col = -1;
+    int count = 0;
+    int seen_cols = 0;
+    for (int row = 0;row < khoigach->side;++row)
+    {
+        for (int col = 0;col < khoigach->side;++col)
+        {
+            u8 value = tetrino_get(khoigach, row, col, rotation);
+            if (value)
+            {
+                shape.value = value;
+                shape.cell_row[count] = (u8)row;
+                shape.cell_col[count] = (u8)col;
+                shape.row_masks[row] |= (u16)(1 << col);
+                if (!(seen_cols & (1 << col)))
+                {
+                    shape.column_top[col] = (u8)row;
+                    seen_cols |= 1 << col;
+                }
+                shape.column_bottom[col] = (u8)row;
+                shape.min_row = row < shape.min_row ? row : shape.min_row;
+                shape.max_row = row > shape.max_row ? row : shape.max_row;
+                shape.min_col = col < shape.min_col ? col : shape.min_col;
+                shape.max_col = col > shape.max_col ? col : shape.max_col;
+                ++count;
+            }
+        }
+    }
+    return shape;
+}
+
+constexpr Tetrino_Shapes make_tetrino_shapes()
+{
+    Tetrino_Shapes result = {};
+    for (int index = 0;index < (int)ARRAY_COUNT(KHOIGACH);++index)
+    {
+        for (int rotation = 0;rotation < 4;++rotation)
+        {
+            result.shapes[index][rotation] = make_tetrino_shape(KHOIGACH + index, rotation);
+        }
+    }
+    return result;
+}
+
+constexpr Tetrino_Shapes TETRINO_SHAPES = make_tetrino_shapes();
+
+inline const Tetrino_Shape *tetrino_shape(u8 tetrino_index, int rotation)
+{
+    return &TETRINO_SHAPES.shapes[tetrino_index][rotation];
+}
+
+struct Zobrist_Keys
+{
+    u64 cells[HEIGHT][WIDTH];
+    u64 tetrino[ARRAY_COUNT(KHOIGACH)][4];
+    u64 piece_row[HEIGHT + 3];
+    u64 piece_col[WIDTH + 3];
+    u64 next_pieces[NEXT_PIECE_COUNT][ARRAY_COUNT(KHOIGACH)];
+};
+
+constexpr u64 zobrist_next(u64 *state)
+{
+    u64 z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+constexpr Zobrist_Keys make_zobrist_keys()
+{
+    Zobrist_Keys keys = {};
+    u64 state = 0x5445545249535A42ull;
+    for (int row = 0;row < HEIGHT;++row)
+    {
+        for (int col = 0;col < WIDTH;++col)
+        {
+            keys.cells[row][col] = zobrist_next(&state);
+        }
+    }
+    for (int index = 0;index < (int)ARRAY_COUNT(KHOIGACH);++index)
+    {
+        for (int rotation = 0;rotation < 4;++rotation)
+        {
+            keys.tetrino[index][rotation] = zobrist_next(&state);
+        }
+        for (int slot = 0;slot < NEXT_PIECE_COUNT;++slot)
+        {
+            keys.next_pieces[slot][index] = zobrist_next(&state);
+        }
+    }
+    for (int row = 0;row < HEIGHT + 3;++row)
+    {
+        keys.piece_row[row] = zobrist_next(&state);
+    }
+    for (int col = 0;col < WIDTH + 3;++col)
+    {
+        keys.piece_col[col] = zobrist_next(&state);
+    }
+    return keys;
+}
+
+constexpr Zobrist_Keys ZOBRIST = make_zobrist_keys();
+
+inline u64 zobrist_row(int row, u16 mask)
+{
+    u64 hash = 0;
+    while (mask)
+    {
+        hash ^= ZOBRIST.cells[row][__builtin_ctz(mask)];
+        mask &= mask - 1;
+    }
+    return hash;
+}
+
+inline u64 zobrist_board(const u16 *rows)
+{
+    u64 hash = 0;
+    for (int row = 0;row < HEIGHT;++row)
+    {
+        hash ^= zobrist_row(row, rows[row]);
+    }
+    return hash;
+}
+
+inline u64 zobrist_piece(const Piece_State *piece)
+{
+    return ZOBRIST.tetrino[piece->tetrino_index][piece->rotation]
+        ^ ZOBRIST.piece_row[piece->offset_row + 3]
+        ^ ZOBRIST.piece_col[piece->offset_col + 3];
+}
+
+inline u64 game_hash(const Game_State *game)
+{
+    u64 hash = game->board_hash ^ zobrist_piece(&game->piece);
+    for (int slot = 0;slot < NEXT_PIECE_COUNT;++slot)
+    {
+        hash ^= ZOBRIST.next_pieces[slot][game->next_pieces[slot]];
+    }
+    return hash;
+}
+
+template <int W, int H>
+inline void build_columns(const Bit_Row<W> *rows, Bit_Row<H + 1> *columns)
+{
+    for (int col = 0;col < W;++col)
+    {
+        columns[col] = 0;
+    }
+    for (int row = 0;row < H;++row)
+    {
+        for (u64 mask = rows[row];mask;mask &= mask - 1)
+        {
+            columns[__builtin_ctzll(mask)] |= (Bit_Row<H + 1>)1 << row;
+        }
+    }
+}
+
+// Number of rows the piece can fall before it lands, from the column
+// bitboards. Gives the same answer as stepping down one row at a time with
+// check_piece_valid.
+template <int W, int H>
+inline int drop_distance(const Piece_State *piece, const Bit_Row<H + 1> *columns)
+{
+    typedef Bit_Row<H + 1> Column;
+    const Tetrino_Shape *shape = tetrino_shape(piece->tetrino_index, piece->rotation);
+    int distance = H;
+    for (int col = shape->min_col;col <= shape->max_col;++col)
+    {
+        Column column = columns[piece->offset_col + col] | ((Column)1 << H);
+        int top = piece->offset_row + shape->column_top[col];
+        if (top >= 0)
+        {
+            column &= ~(((Column)2 << top) - 1);
+        }
+        int blocked = __builtin_ctzll(column) - (piece->offset_row + shape->column_bottom[col]);
+        blocked = blocked < 1 ? 1 : blocked;
+        distance = blocked - 1 < distance ? blocked - 1 : distance;
+    }
+    return distance;
+}
+
+template <int W, int H>
+inline int find_lines(const Bit_Row<W> *rows, u8 *lines_out)
+{
+    int count = 0;
+    for (int row = 0;row < H;++row)
+    {
+        u8 filled = rows[row] == Board<W, H>::FULL_ROW;
+        lines_out[row] = filled;
+        count += filled;
+    }
+    return count;
+}
+
+// When hash is given it holds the Zobrist hash of rows and is kept up to
+// date. Only the standard board has Zobrist keys, other sizes ignore it.
+template <int W, int H>
+inline void clear_lines(u8 *cells, Bit_Row<W> *rows, const u8 *lines, u64 *hash)
+{
+    int src_row = H - 1;
+    for (int dst_row = H - 1;dst_row >= 0;--dst_row)
+    {
+        while (src_row >= 0 && lines[src_row])
+        {
+            --src_row;
+        }
+        if (src_row < 0)
+        {
+            memset(cells + dst_row * W, 0, W);
+            if constexpr (W == WIDTH && H == HEIGHT)
+            {
+                if (hash)
+                {
+                    *hash ^= zobrist_row(dst_row, rows[dst_row]);
+                }
+            }
+            rows[dst_row] = 0;
+        }
+        else
+        {
+            if (src_row != dst_row)
+            {
+                memcpy(cells + dst_row * W, cells + src_row * W, W);
+                if constexpr (W == WIDTH && H == HEIGHT)
+                {
+                    if (hash)
+                    {
+                        *hash ^= zobrist_row(dst_row, rows[dst_row]) ^
+                            zobrist_row(dst_row, rows[src_row]);
+                    }
+                }
+                rows[dst_row] = rows[src_row];
+            }
+            --src_row;
+        }
+    }
+}
+
+template <int W, int H>
+inline bool check_piece_valid(const Piece_State *piece, const Bit_Row<W> *rows)
+{
+    typedef Bit_Row<W> Row;
+    const Tetrino_Shape *shape = tetrino_shape(piece->tetrino_index, piece->rotation);
+
+    if (piece->offset_row + shape->min_row < 0 ||
+        piece->offset_row + shape->max_row >= H ||
+        piece->offset_col + shape->min_col < 0 ||
+        piece->offset_col + shape->max_col >= W)
+    {
+        return false;
+    }
+    for (int row = shape->min_row;row <= shape->max_row;++row)
+    {
+        Row mask = piece->offset_col >= 0
+            ? (Row)((Row)shape->row_masks[row] << piece->offset_col)
+            : (Row)(shape->row_masks[row] >> -piece->offset_col);
+        if (rows[piece->offset_row + row] & mask)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <int W, int H>
+inline void board_clear(Board<W, H> *board)
+{
+    memset(board, 0, sizeof(*board));
+}
+
+int count_points(int level, int line_count);
+void merge_piece(Game_State *game);
+void game_init(Game_State *game, u64 seed, Randomizer randomizer);
+void game_begin(Game_State *game, int start_level);
+void spawn_piece(Game_State *game);
+void update_game(Game_State *game , const Input_State *input);
+
+#endif
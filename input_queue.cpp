@@ -0,0 +1,40 @@
+#include "input_queue.h"
+
+bool input_queue_push(Input_Queue *queue, u64 time, u8 key, bool pressed)
+{
+    if (queue->tail - queue->head >= INPUT_QUEUE_CAPACITY)
+    {
+        return false;
+    }
+    Input_Event *event = queue->events + queue->tail % INPUT_QUEUE_CAPACITY;
+    event->time = time;
+    event->key = key;
+    event->pressed = pressed;
+    ++queue->tail;
+    return true;
+}
+
+void input_queue_apply(Input_Queue *queue, u64 time, Input_State *input)
+{
+    u8 prev_held = queue->held;
+    u8 pressed = 0;
+    while (queue->head != queue->tail)
+    {
+        const Input_Event *event = queue->events + queue->head % INPUT_QUEUE_CAPACITY;
+        if (event->time > time)
+        {
+            break;
+        }
+        if (event->pressed)
+        {
+            pressed |= event->key & ~queue->held;
+            queue->held |= event->key;
+        }
+        else
+        {
+            queue->held &= ~event->key;
+        }
+        ++queue->head;
+    }
+    input_set_keys(input, queue->held, prev_held, pressed);
+}
@@ -0,0 +1,32 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include "game.h"
+
+#define INPUT_QUEUE_CAPACITY 256
+
+struct Input_Event
+{
+    u64 time;
+    u8 key;
+    bool pressed;
+};
+
+// Key presses and releases in the order they happened, each stamped with
+// the time it happened in the caller's clock. The fixed-step loop drains the
+// events up to each tick's time, so several presses within one frame land on
+// the ticks they belong to and a press released within one tick still counts.
+struct Input_Queue
+{
+    Input_Event events[INPUT_QUEUE_CAPACITY];
+    u32 head;
+    u32 tail;
+    u8 held;
+};
+
+// Returns false and drops the event when the queue is full.
+bool input_queue_push(Input_Queue *queue, u64 time, u8 key, bool pressed);
+// Applies every event at or before time and sets input for that tick.
+void input_queue_apply(Input_Queue *queue, u64 time, Input_State *input);
+
+#endif
@@ -0,0 +1,530 @@
+#include <algorithm>
+#include <math.h>
+#include <vector>
+#include "leaderboard.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+
+inline bool file_seek(FILE *file, u64 offset)
+{
+    return _fseeki64(file, (long long)offset, SEEK_SET) == 0;
+}
+
+inline u64 file_size(FILE *file)
+{
+    _fseeki64(file, 0, SEEK_END);
+    return (u64)_ftelli64(file);
+}
+
+inline bool file_truncate(FILE *file, u64 size)
+{
+    return _chsize_s(_fileno(file), (long long)size) == 0;
+}
+
+inline bool file_sync(FILE *file)
+{
+    return _commit(_fileno(file)) == 0;
+}
+
+inline bool replace_file(const char *from, const char *to)
+{
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+#else
+#include <unistd.h>
+
+inline bool file_seek(FILE *file, u64 offset)
+{
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+}
+
+inline u64 file_size(FILE *file)
+{
+    fseeko(file, 0, SEEK_END);
+    return (u64)ftello(file);
+}
+
+inline bool file_truncate(FILE *file, u64 size)
+{
+    return ftruncate(fileno(file), (off_t)size) == 0;
+}
+
+inline bool file_sync(FILE *file)
+{
+    return fsync(fileno(file)) == 0;
+}
+
+inline bool replace_file(const char *from, const char *to)
+{
+    return rename(from, to) == 0;
+}
+
+#endif
+
+const u8 LOG_MAGIC[4] = { 'T', 'S', 'C', 'L' };
+const u8 INDEX_MAGIC[4] = { 'T', 'S', 'C', 'I' };
+
+struct Index_Header
+{
+    u8 magic[4];
+    u16 version;
+    u16 level_count;
+    u32 record_count;
+    u32 last_checksum;
+};
+
+static_assert(sizeof(Index_Header) == LEADERBOARD_INDEX_HEADER_SIZE, "score index header layout");
+
+inline u32 record_checksum(const Score_Record *record)
+{
+    return fnv1a(FNV_OFFSET, (const u8 *)record, offsetof(Score_Record, checksum));
+}
+
+void score_record_from_game(const Game_State *game, u32 ticks, Score_Source source,
+                            u32 time, Score_Record *record)
+{
+    memset(record, 0, sizeof(*record));
+    record->seed = game->seed;
+    record->time = time;
+    record->points = game->points;
+    record->line_count = game->line_count;
+    record->ticks = ticks;
+    record->piece_count = (u32)game->piece_count;
+    record->start_level = (u16)game->start_level;
+    record->level = (u16)game->level;
+    record->source = (u8)source;
+    record->randomizer = (u8)game->randomizer;
+    record->checksum = record_checksum(record);
+}
+
+bool leaderboard_writer_open(Leaderboard_Writer *writer, const char *path)
+{
+    writer->file = fopen(path, "r+b");
+    if (!writer->file)
+    {
+        writer->file = fopen(path, "w+b");
+    }
+    if (!writer->file)
+    {
+        return false;
+    }
+    FILE *file = writer->file;
+    u64 size = file_size(file);
+    u8 header[LEADERBOARD_LOG_HEADER_SIZE] = { 'T', 'S', 'C', 'L',
+        (u8)LEADERBOARD_VERSION, (u8)(LEADERBOARD_VERSION >> 8),
+        (u8)sizeof(Score_Record), (u8)(sizeof(Score_Record) >> 8) };
+    if (size < LEADERBOARD_LOG_HEADER_SIZE)
+    {
+        // Empty, or a crash while the header was being written.
+        if (!file_truncate(file, 0) || !file_seek(file, 0) ||
+            fwrite(header, 1, sizeof(header), file) != sizeof(header))
+        {
+            leaderboard_writer_close(writer);
+            return false;
+        }
+        fflush(file);
+        return true;
+    }
+
+    u8 existing[LEADERBOARD_LOG_HEADER_SIZE];
+    if (!file_seek(file, 0) || fread(existing, 1, sizeof(existing), file) != sizeof(existing) ||
+        memcmp(existing, header, sizeof(header)) != 0)
+    {
+        leaderboard_writer_close(writer);
+        return false;
+    }
+    u64 count = (size - LEADERBOARD_LOG_HEADER_SIZE) / sizeof(Score_Record);
+    while (count > 0)
+    {
+        Score_Record record;
+        if (!file_seek(file, LEADERBOARD_LOG_HEADER_SIZE + (count - 1) * sizeof(Score_Record)) ||
+            fread(&record, sizeof(record), 1, file) != 1)
+        {
+            leaderboard_writer_close(writer);
+            return false;
+        }
+        if (record.checksum == record_checksum(&record))
+        {
+            break;
+        }
+        --count;
+    }
+    u64 valid_size = LEADERBOARD_LOG_HEADER_SIZE + count * sizeof(Score_Record);
+    if ((valid_size != size && !file_truncate(file, valid_size)) || !file_seek(file, valid_size))
+    {
+        leaderboard_writer_close(writer);
+        return false;
+    }
+    return true;
+}
+
+bool leaderboard_append(Leaderboard_Writer *writer, const Score_Record *records, u32 count)
+{
+    if (fwrite(records, sizeof(Score_Record), count, writer->file) != count)
+    {
+        return false;
+    }
+    return fflush(writer->file) == 0;
+}
+
+bool leaderboard_writer_close(Leaderboard_Writer *writer)
+{
+    if (!writer->file)
+    {
+        return true;
+    }
+    bool ok = fflush(writer->file) == 0 && file_sync(writer->file);
+    ok = fclose(writer->file) == 0 && ok;
+    writer->file = 0;
+    return ok;
+}
+
+void open_index(Leaderboard *board, const char *index_path)
+{
+    if (!index_path || !map_file(index_path, &board->index))
+    {
+        return;
+    }
+    const u8 *data = board->index.data;
+    size_t size = board->index.size;
+    Index_Header header;
+    if (size < sizeof(header))
+    {
+        unmap_file(&board->index);
+        return;
+    }
+    memcpy(&header, data, sizeof(header));
+    size_t expected = sizeof(header) + header.level_count * sizeof(Leaderboard_Level) +
+                      2 * (size_t)header.record_count * sizeof(Score_Entry);
+    bool valid = memcmp(header.magic, INDEX_MAGIC, 4) == 0 &&
+                 header.version == LEADERBOARD_VERSION && size == expected &&
+                 header.record_count <= board->record_count &&
+                 (header.record_count == 0 ||
+                  board->records[header.record_count - 1].checksum == header.last_checksum);
+    if (!valid)
+    {
+        unmap_file(&board->index);
+        return;
+    }
+    board->indexed_count = header.record_count;
+    board->level_count = header.level_count;
+    board->levels = (const Leaderboard_Level *)(data + sizeof(header));
+    board->all = (const Score_Entry *)(board->levels + header.level_count);
+    board->by_level = board->all + header.record_count;
+}
+
+bool leaderboard_open(Leaderboard *board, const char *log_path, const char *index_path)
+{
+    memset(board, 0, sizeof(*board));
+    if (!map_file(log_path, &board->log))
+    {
+        // No log yet is an empty leaderboard.
+        return true;
+    }
+    const u8 *data = board->log.data;
+    size_t size = board->log.size;
+    if (size < LEADERBOARD_LOG_HEADER_SIZE || memcmp(data, LOG_MAGIC, 4) != 0 ||
+        (data[4] | data[5] << 8) != LEADERBOARD_VERSION ||
+        (data[6] | data[7] << 8) != sizeof(Score_Record))
+    {
+        unmap_file(&board->log);
+        return size == 0;
+    }
+    board->records = (const Score_Record *)(data + LEADERBOARD_LOG_HEADER_SIZE);
+    board->record_count = (u32)((size - LEADERBOARD_LOG_HEADER_SIZE) / sizeof(Score_Record));
+    open_index(board, index_path);
+
+    // Indexed records were checked when the index was built. A bad record
+    // in the tail is a torn append and ends the log.
+    for (u32 i = board->indexed_count;i < board->record_count;++i)
+    {
+        if (board->records[i].checksum != record_checksum(board->records + i))
+        {
+            board->record_count = i;
+            break;
+        }
+    }
+    return true;
+}
+
+void leaderboard_close(Leaderboard *board)
+{
+    unmap_file(&board->index);
+    unmap_file(&board->log);
+    memset(board, 0, sizeof(*board));
+}
+
+struct Best_First
+{
+    bool operator()(const Score_Entry &a, const Score_Entry &b) const
+    {
+        return a.points != b.points ? a.points > b.points : a.record < b.record;
+    }
+};
+
+struct Level_Then_Best_First
+{
+    const Score_Record *records;
+
+    bool operator()(const Score_Entry &a, const Score_Entry &b) const
+    {
+        u16 a_level = records[a.record].start_level;
+        u16 b_level = records[b.record].start_level;
+        if (a_level != b_level)
+        {
+            return a_level < b_level;
+        }
+        return Best_First()(a, b);
+    }
+};
+
+bool write_index(const char *path, const Index_Header *header,
+                 const std::vector<Leaderboard_Level> &levels,
+                 const std::vector<Score_Entry> &all, const std::vector<Score_Entry> &by_level)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        return false;
+    }
+    bool ok = fwrite(header, sizeof(*header), 1, file) == 1;
+    ok = ok && fwrite(levels.data(), sizeof(Leaderboard_Level), levels.size(), file) == levels.size();
+    ok = ok && fwrite(all.data(), sizeof(Score_Entry), all.size(), file) == all.size();
+    ok = ok && fwrite(by_level.data(), sizeof(Score_Entry), by_level.size(), file) == by_level.size();
+    ok = fflush(file) == 0 && file_sync(file) && ok;
+    ok = fclose(file) == 0 && ok;
+    return ok;
+}
+
+bool leaderboard_build_index(const Leaderboard *board, const char *index_path)
+{
+    u32 old_count = board->indexed_count;
+    u32 count = board->record_count;
+    std::vector<Score_Entry> added(count - old_count);
+    for (u32 i = old_count;i < count;++i)
+    {
+        added[i - old_count] = { board->records[i].points, i };
+    }
+
+    std::vector<Score_Entry> all(count);
+    std::sort(added.begin(), added.end(), Best_First());
+    std::merge(board->all, board->all + old_count, added.begin(), added.end(), all.begin(),
+               Best_First());
+
+    std::vector<Score_Entry> by_level(count);
+    Level_Then_Best_First by_level_order = { board->records };
+    std::sort(added.begin(), added.end(), by_level_order);
+    std::merge(board->by_level, board->by_level + old_count, added.begin(), added.end(),
+               by_level.begin(), by_level_order);
+
+    std::vector<Leaderboard_Level> levels;
+    for (u32 i = 0;i < count;++i)
+    {
+        u32 start_level = board->records[by_level[i].record].start_level;
+        if (levels.empty() || levels.back().start_level != start_level)
+        {
+            levels.push_back({ start_level, i, 0 });
+        }
+        ++levels.back().count;
+    }
+
+    Index_Header header;
+    memcpy(header.magic, INDEX_MAGIC, 4);
+    header.version = LEADERBOARD_VERSION;
+    header.level_count = (u16)levels.size();
+    header.record_count = count;
+    header.last_checksum = count ? board->records[count - 1].checksum : 0;
+
+    // Written aside and renamed over the old index, so a crash leaves one
+    // or the other.
+    char temp_path[1024];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", index_path);
+    if (!write_index(temp_path, &header, levels, all, by_level))
+    {
+        remove(temp_path);
+        return false;
+    }
+    return replace_file(temp_path, index_path);
+}
+
+// The indexed results of a start level, best first.
+u32 index_range(const Leaderboard *board, int start_level, const Score_Entry **entries)
+{
+    if (start_level == LEADERBOARD_ALL_LEVELS)
+    {
+        *entries = board->all;
+        return board->indexed_count;
+    }
+    const Leaderboard_Level *end = board->levels + board->level_count;
+    const Leaderboard_Level *level = std::lower_bound(board->levels, end, (u32)start_level,
+        [](const Leaderboard_Level &level, u32 value) { return level.start_level < value; });
+    if (level == end || level->start_level != (u32)start_level)
+    {
+        *entries = 0;
+        return 0;
+    }
+    *entries = board->by_level + level->first;
+    return level->count;
+}
+
+inline bool tail_matches(const Score_Record *record, int start_level)
+{
+    return start_level == LEADERBOARD_ALL_LEVELS || record->start_level == start_level;
+}
+
+// The unindexed results of a start level, best first.
+void sorted_tail(const Leaderboard *board, int start_level, std::vector<Score_Entry> *tail)
+{
+    tail->clear();
+    for (u32 i = board->indexed_count;i < board->record_count;++i)
+    {
+        if (tail_matches(board->records + i, start_level))
+        {
+            tail->push_back({ board->records[i].points, i });
+        }
+    }
+    std::sort(tail->begin(), tail->end(), Best_First());
+}
+
+u32 leaderboard_count(const Leaderboard *board, int start_level)
+{
+    const Score_Entry *entries;
+    u32 count = index_range(board, start_level, &entries);
+    for (u32 i = board->indexed_count;i < board->record_count;++i)
+    {
+        count += tail_matches(board->records + i, start_level);
+    }
+    return count;
+}
+
+u32 leaderboard_count_at_least(const Leaderboard *board, int start_level, int points)
+{
+    const Score_Entry *entries;
+    u32 indexed = index_range(board, start_level, &entries);
+    const Score_Entry *end = std::partition_point(entries, entries + indexed,
+        [points](const Score_Entry &entry) { return entry.points >= points; });
+    u32 count = (u32)(end - entries);
+    for (u32 i = board->indexed_count;i < board->record_count;++i)
+    {
+        const Score_Record *record = board->records + i;
+        count += tail_matches(record, start_level) && record->points >= points;
+    }
+    return count;
+}
+
+u32 leaderboard_top(const Leaderboard *board, int start_level, u32 k, u32 *records)
+{
+    const Score_Entry *entries;
+    u32 indexed = index_range(board, start_level, &entries);
+    std::vector<Score_Entry> tail;
+    for (u32 i = board->indexed_count;i < board->record_count;++i)
+    {
+        if (tail_matches(board->records + i, start_level))
+        {
+            tail.push_back({ board->records[i].points, i });
+        }
+    }
+    u32 tail_count = (u32)tail.size() < k ? (u32)tail.size() : k;
+    std::partial_sort(tail.begin(), tail.begin() + tail_count, tail.end(), Best_First());
+    u32 count = 0;
+    u32 i = 0;
+    u32 j = 0;
+    while (count < k && (i < indexed || j < tail_count))
+    {
+        bool take_index = j == tail_count ||
+                          (i < indexed && Best_First()(entries[i], tail[j]));
+        records[count++] = take_index ? entries[i++].record : tail[j++].record;
+    }
+    return count;
+}
+
+int leaderboard_points_at_rank(const Leaderboard *board, int start_level, u32 rank)
+{
+    const Score_Entry *entries;
+    u32 indexed = index_range(board, start_level, &entries);
+    std::vector<Score_Entry> tail;
+    sorted_tail(board, start_level, &tail);
+    u32 tail_count = (u32)tail.size();
+
+    // Takes i results from the index and rank + 1 - i from the tail, with
+    // the smallest i for which the next indexed result is not better than
+    // the last one taken from the tail.
+    u32 take = rank + 1;
+    u32 low = take > tail_count ? take - tail_count : 0;
+    u32 high = take < indexed ? take : indexed;
+    while (low < high)
+    {
+        u32 i = low + (high - low) / 2;
+        u32 j = take - i;
+        if (j > 0 && entries[i].points > tail[j - 1].points)
+        {
+            low = i + 1;
+        }
+        else
+        {
+            high = i;
+        }
+    }
+    u32 j = take - low;
+    if (low == 0)
+    {
+        return tail[j - 1].points;
+    }
+    if (j == 0)
+    {
+        return entries[low - 1].points;
+    }
+    int a = entries[low - 1].points;
+    int b = tail[j - 1].points;
+    return a < b ? a : b;
+}
+
+int leaderboard_percentile(const Leaderboard *board, int start_level, double fraction)
+{
+    u32 count = leaderboard_count(board, start_level);
+    if (count == 0)
+    {
+        return 0;
+    }
+    double rank = ceil(fraction * count);
+    u32 index = rank <= 1.0 ? 0 : (u32)rank - 1;
+    return leaderboard_points_at_rank(board, start_level, index < count ? index : count - 1);
+}
+
+int leaderboard_best(const Leaderboard *board, int start_level)
+{
+    const Score_Entry *entries;
+    bool found = index_range(board, start_level, &entries) > 0;
+    int best = found ? entries[0].points : 0;
+    for (u32 i = board->indexed_count;i < board->record_count;++i)
+    {
+        const Score_Record *record = board->records + i;
+        if (tail_matches(record, start_level) && (!found || record->points > best))
+        {
+            best = record->points;
+            found = true;
+        }
+    }
+    return best;
+}
+
+int leaderboard_load_high_score(const char *log_path, const char *index_path, u32 index_tail)
+{
+    Leaderboard board;
+    if (!leaderboard_open(&board, log_path, index_path))
+    {
+        return 0;
+    }
+    if (board.record_count - board.indexed_count > index_tail &&
+        leaderboard_build_index(&board, index_path))
+    {
+        leaderboard_close(&board);
+        leaderboard_open(&board, log_path, index_path);
+    }
+    int best = leaderboard_best(&board, LEADERBOARD_ALL_LEVELS);
+    leaderboard_close(&board);
+    return best;
+}
@@ -0,0 +1,133 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <stdio.h>
+#include "game.h"
+#include "mapped_file.h"
+
+// Score log, append-only, all integers little-endian:
+//   header   "TSCL", u16 version, u16 record size
+//   records  Score_Record, each with an FNV-1a checksum of its other bytes.
+//            A record cut short or with a bad checksum at the end of the log
+//            is the remains of an interrupted append and is dropped.
+// Score index, rebuilt from the log and replaced with a rename:
+//   header   "TSCI", u16 version, u16 level count, u32 record count,
+//            u32 checksum of the last indexed record
+//   levels   Leaderboard_Level for each start level, ascending
+//   all      Score_Entry for each indexed record, best first
+//   by_level Score_Entry for each indexed record by start level, then best
+//            first
+// Entries with equal points keep log order. Records appended after the
+// index was built are scanned by every query until it is rebuilt.
+
+#define LEADERBOARD_LOG_PATH "scores.log"
+#define LEADERBOARD_INDEX_PATH "scores.idx"
+#define LEADERBOARD_VERSION 1
+#define LEADERBOARD_LOG_HEADER_SIZE 8
+#define LEADERBOARD_INDEX_HEADER_SIZE 16
+#define LEADERBOARD_ALL_LEVELS -1
+
+enum Score_Source
+{
+    SCORE_SOURCE_PLAYER,
+    SCORE_SOURCE_BOT,
+    SCORE_SOURCE_RANDOM
+};
+
+struct Score_Record
+{
+    // Replays the game with game_init and game_begin. Player games after the
+    // first of a session go on from the one before, so they are logged with
+    // seed 0 and cannot be replayed from the log.
+    u64 seed;
+    u32 time;
+    int points;
+    int line_count;
+    u32 ticks;
+    u32 piece_count;
+    u16 start_level;
+    u16 level;
+    u8 source;
+    u8 randomizer;
+    u8 reserved[2];
+    u32 checksum;
+};
+
+struct Score_Entry
+{
+    int points;
+    u32 record;
+};
+
+struct Leaderboard_Level
+{
+    u32 start_level;
+    u32 first;
+    u32 count;
+};
+
+static_assert(sizeof(Score_Record) == 40, "score record layout");
+static_assert(sizeof(Score_Entry) == 8, "score entry layout");
+static_assert(sizeof(Leaderboard_Level) == 12, "score level layout");
+
+// Fills a record for a finished game, checksum included. time is the wall
+// clock in seconds.
+void score_record_from_game(const Game_State *game, u32 ticks, Score_Source source,
+                            u32 time, Score_Record *record);
+
+// Only one writer may have a log open at a time.
+struct Leaderboard_Writer
+{
+    FILE *file;
+};
+
+// Creates the log if it is missing and drops a torn record left at its end.
+bool leaderboard_writer_open(Leaderboard_Writer *writer, const char *path);
+// Appends and flushes, so a process that dies after this keeps the records.
+bool leaderboard_append(Leaderboard_Writer *writer, const Score_Record *records, u32 count);
+// Syncs the log to disk before closing it.
+bool leaderboard_writer_close(Leaderboard_Writer *writer);
+
+struct Leaderboard
+{
+    Mapped_File log;
+    Mapped_File index;
+    const Score_Record *records;
+    u32 record_count;
+    u32 indexed_count;
+    const Leaderboard_Level *levels;
+    u32 level_count;
+    const Score_Entry *all;
+    const Score_Entry *by_level;
+};
+
+// Maps the log and the index. A missing log is an empty leaderboard, and a
+// missing index or one that does not match the log leaves every record in
+// the unindexed tail.
+bool leaderboard_open(Leaderboard *board, const char *log_path, const char *index_path);
+void leaderboard_close(Leaderboard *board);
+// Writes an index of every record, merging the unindexed tail into the
+// current index instead of sorting everything again.
+bool leaderboard_build_index(const Leaderboard *board, const char *index_path);
+
+// start_level is LEADERBOARD_ALL_LEVELS or a start level to query.
+u32 leaderboard_count(const Leaderboard *board, int start_level);
+// Number of results with at least the given points.
+u32 leaderboard_count_at_least(const Leaderboard *board, int start_level, int points);
+// Writes the record numbers of the best results, best first, and returns
+// how many there were, at most k.
+u32 leaderboard_top(const Leaderboard *board, int start_level, u32 k, u32 *records);
+// Points of the result at rank, 0 being the best. rank must be below the
+// count.
+int leaderboard_points_at_rank(const Leaderboard *board, int start_level, u32 rank);
+// Points reached by the best fraction of results, so 0.5 gives the median
+// and 0.01 the cutoff for the top 1%. 0 when there are no results.
+int leaderboard_percentile(const Leaderboard *board, int start_level, double fraction);
+// Best points, 0 when there are none.
+int leaderboard_best(const Leaderboard *board, int start_level);
+
+// Opens the leaderboard, rebuilds the index first when more than
+// index_tail records are unindexed, and returns the best points.
+int leaderboard_load_high_score(const char *log_path, const char *index_path, u32 index_tail);
+
+#endif
@@ -0,0 +1,182 @@
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "leaderboard.h"
+
+const char *SOURCE_NAMES[] = { "player", "bot", "random" };
+
+void print_usage(const char *program)
+{
+    printf("usage: %s index [-f log] [-i index]\n"
+           "       %s info [-f log] [-i index]\n"
+           "       %s top [-k count] [-l start_level] [-f log] [-i index]\n"
+           "       %s percentile [-p top_percent] [-l start_level] [-f log] [-i index]\n"
+           "       %s rank -r points [-l start_level] [-f log] [-i index]\n",
+           program, program, program, program, program);
+}
+
+struct Options
+{
+    const char *log_path;
+    const char *index_path;
+    int start_level;
+    u32 count;
+    double percent;
+    int points;
+    bool has_points;
+};
+
+bool parse_options(int argc, char* argv[], Options *options)
+{
+    options->log_path = LEADERBOARD_LOG_PATH;
+    options->index_path = LEADERBOARD_INDEX_PATH;
+    options->start_level = LEADERBOARD_ALL_LEVELS;
+    options->count = 10;
+    options->percent = 50.0;
+    for (int i = 2;i < argc;++i)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : 0;
+        if (!value || arg[0] != '-' || strlen(arg) != 2)
+        {
+            return false;
+        }
+        switch (arg[1])
+        {
+        case 'f':
+            options->log_path = value;
+            break;
+        case 'i':
+            options->index_path = value;
+            break;
+        case 'l':
+            options->start_level = atoi(value);
+            break;
+        case 'k':
+            options->count = (u32)strtoul(value, 0, 10);
+            break;
+        case 'p':
+            options->percent = atof(value);
+            break;
+        case 'r':
+            options->points = atoi(value);
+            options->has_points = true;
+            break;
+        default:
+            return false;
+        }
+        ++i;
+    }
+    return true;
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int build_index(const Leaderboard *board, const Options *options)
+{
+    auto start = std::chrono::steady_clock::now();
+    if (!leaderboard_build_index(board, options->index_path))
+    {
+        fprintf(stderr, "cannot write %s\n", options->index_path);
+        return 1;
+    }
+    printf("indexed %u records (%u new) in %.1f ms\n", board->record_count,
+           board->record_count - board->indexed_count, elapsed_ms(start));
+    return 0;
+}
+
+void print_info(const Leaderboard *board)
+{
+    printf("records: %u\nindexed: %u\n", board->record_count, board->indexed_count);
+    for (u32 i = 0;i < board->level_count;++i)
+    {
+        const Leaderboard_Level *level = board->levels + i;
+        printf("start level %u: %u indexed, best %d\n", level->start_level, level->count,
+               board->by_level[level->first].points);
+    }
+}
+
+int print_top(const Leaderboard *board, const Options *options)
+{
+    auto start = std::chrono::steady_clock::now();
+    u32 *records = new u32[options->count];
+    u32 count = leaderboard_top(board, options->start_level, options->count, records);
+    double ms = elapsed_ms(start);
+    printf("%4s %10s %6s %5s %5s %8s %-6s %s\n", "rank", "points", "lines", "start",
+           "level", "ticks", "source", "seed");
+    for (u32 i = 0;i < count;++i)
+    {
+        const Score_Record *record = board->records + records[i];
+        char seed[24] = "-";
+        if (record->seed || record->source != SCORE_SOURCE_PLAYER)
+        {
+            snprintf(seed, sizeof(seed), "%llu", (unsigned long long)record->seed);
+        }
+        printf("%4u %10d %6d %5u %5u %8u %-6s %s\n", i + 1, record->points,
+               record->line_count, record->start_level, record->level, record->ticks,
+               record->source < ARRAY_COUNT(SOURCE_NAMES) ? SOURCE_NAMES[record->source] : "?",
+               seed);
+    }
+    printf("query: %.3f ms\n", ms);
+    delete[] records;
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    Options options = {};
+    if (argc < 2 || !parse_options(argc, argv, &options))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const char *command = argv[1];
+    Leaderboard board;
+    if (!leaderboard_open(&board, options.log_path, options.index_path))
+    {
+        fprintf(stderr, "cannot read %s\n", options.log_path);
+        return 1;
+    }
+
+    int result = 0;
+    if (strcmp(command, "index") == 0)
+    {
+        result = build_index(&board, &options);
+    }
+    else if (strcmp(command, "info") == 0)
+    {
+        print_info(&board);
+    }
+    else if (strcmp(command, "top") == 0)
+    {
+        result = print_top(&board, &options);
+    }
+    else if (strcmp(command, "percentile") == 0)
+    {
+        auto start = std::chrono::steady_clock::now();
+        int points = leaderboard_percentile(&board, options.start_level, options.percent / 100.0);
+        double ms = elapsed_ms(start);
+        printf("top %g%% of %u results reach %d points\nquery: %.3f ms\n", options.percent,
+               leaderboard_count(&board, options.start_level), points, ms);
+    }
+    else if (strcmp(command, "rank") == 0 && options.has_points)
+    {
+        auto start = std::chrono::steady_clock::now();
+        u32 above = leaderboard_count_at_least(&board, options.start_level, options.points + 1);
+        u32 count = leaderboard_count(&board, options.start_level);
+        double ms = elapsed_ms(start);
+        printf("%d points ranks %u of %u (top %.3f%%)\nquery: %.3f ms\n", options.points,
+               above + 1, count, count ? 100.0 * (above + 1) / count : 100.0, ms);
+    }
+    else
+    {
+        print_usage(argv[0]);
+        result = 1;
+    }
+    leaderboard_close(&board);
+    return result;
+}
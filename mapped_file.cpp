@@ -0,0 +1,107 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+
+bool map_file(const char *path, Mapped_File *file)
+{
+    file->data = 0;
+    file->size = 0;
+    file->handle = 0;
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, 0);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size))
+    {
+        CloseHandle(handle);
+        return false;
+    }
+    if (size.QuadPart == 0)
+    {
+        CloseHandle(handle);
+        return true;
+    }
+    HANDLE mapping = CreateFileMappingA(handle, 0, PAGE_READONLY, 0, 0, 0);
+    CloseHandle(handle);
+    if (!mapping)
+    {
+        return false;
+    }
+    const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    file->data = (const u8 *)view;
+    file->size = (size_t)size.QuadPart;
+    file->handle = mapping;
+    return true;
+}
+
+void unmap_file(Mapped_File *file)
+{
+    if (file->data)
+    {
+        UnmapViewOfFile(file->data);
+        CloseHandle((HANDLE)file->handle);
+    }
+    file->data = 0;
+    file->size = 0;
+    file->handle = 0;
+}
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool map_file(const char *path, Mapped_File *file)
+{
+    file->data = 0;
+    file->size = 0;
+    file->handle = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        return false;
+    }
+    if (info.st_size == 0)
+    {
+        close(fd);
+        return true;
+    }
+    void *view = mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+    {
+        return false;
+    }
+    file->data = (const u8 *)view;
+    file->size = (size_t)info.st_size;
+    return true;
+}
+
+void unmap_file(Mapped_File *file)
+{
+    if (file->data)
+    {
+        munmap((void *)file->data, file->size);
+    }
+    file->data = 0;
+    file->size = 0;
+    file->handle = 0;
+}
+
+#endif
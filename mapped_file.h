@@ -0,0 +1,18 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+#include "game.h"
+
+struct Mapped_File
+{
+    const u8 *data;
+    size_t size;
+    void *handle;
+};
+
+// Maps a whole file read-only. Empty files map to data == 0, size == 0.
+bool map_file(const char *path, Mapped_File *file);
+void unmap_file(Mapped_File *file);
+
+#endif
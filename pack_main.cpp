@@ -0,0 +1,378 @@
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "asset_archive.h"
+
+#define WAV_HEADER_SIZE 44
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_FLOAT 3
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+inline u16 get_u16(const u8 *data)
+{
+    return (u16)(data[0] | (data[1] << 8));
+}
+
+inline u32 get_u32(const u8 *data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((u32)data[3] << 24);
+}
+
+inline void put_u16(std::vector<u8> *out, u16 value)
+{
+    out->push_back((u8)value);
+    out->push_back((u8)(value >> 8));
+}
+
+inline void put_u32(std::vector<u8> *out, u32 value)
+{
+    put_u16(out, (u16)value);
+    put_u16(out, (u16)(value >> 16));
+}
+
+inline void put_tag(std::vector<u8> *out, const char *tag)
+{
+    out->insert(out->end(), tag, tag + 4);
+}
+
+struct Pcm
+{
+    u32 frequency;
+    int channels;
+    // Interleaved samples in [-1, 1].
+    std::vector<float> samples;
+};
+
+float read_sample(const u8 *data, int format, int bits)
+{
+    if (format == WAV_FORMAT_FLOAT)
+    {
+        float value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+    switch (bits)
+    {
+    case 8:
+        return (data[0] - 128) / 128.0f;
+    case 16:
+        return (short)get_u16(data) / 32768.0f;
+    case 24:
+        return (int)((u32)data[0] << 8 | (u32)data[1] << 16 | (u32)data[2] << 24) / 2147483648.0f;
+    case 32:
+        return (int)get_u32(data) / 2147483648.0f;
+    }
+    return 0.0f;
+}
+
+// Integer PCM of 8 to 32 bits and 32-bit float, plain or extensible.
+const char *decode_wav(const u8 *data, size_t size, Pcm *pcm)
+{
+    if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0)
+    {
+        return "not a WAV file";
+    }
+    int format = 0;
+    int bits = 0;
+    const u8 *samples = 0;
+    size_t samples_size = 0;
+    pcm->channels = 0;
+    for (size_t offset = 12;offset + 8 <= size;)
+    {
+        const u8 *chunk = data + offset;
+        size_t chunk_size = get_u32(chunk + 4);
+        if (chunk_size > size - offset - 8)
+        {
+            chunk_size = size - offset - 8;
+        }
+        if (memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16)
+        {
+            format = get_u16(chunk + 8);
+            pcm->channels = get_u16(chunk + 10);
+            pcm->frequency = get_u32(chunk + 12);
+            bits = get_u16(chunk + 22);
+            if (format == WAV_FORMAT_EXTENSIBLE && chunk_size >= 26)
+            {
+                format = get_u16(chunk + 32);
+            }
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            samples = chunk + 8;
+            samples_size = chunk_size;
+        }
+        offset += 8 + chunk_size + (chunk_size & 1);
+    }
+    bool supported = (format == WAV_FORMAT_PCM && (bits == 8 || bits == 16 || bits == 24 || bits == 32)) ||
+                     (format == WAV_FORMAT_FLOAT && bits == 32);
+    if (!supported || pcm->channels == 0 || pcm->frequency == 0)
+    {
+        return "unsupported sample format";
+    }
+    if (!samples)
+    {
+        return "no data chunk";
+    }
+    int sample_size = bits / 8;
+    size_t count = samples_size / sample_size;
+    count -= count % pcm->channels;
+    pcm->samples.resize(count);
+    for (size_t i = 0;i < count;++i)
+    {
+        pcm->samples[i] = read_sample(samples + i * sample_size, format, bits);
+    }
+    return 0;
+}
+
+// A frame of output channels from one source frame. With more source channels
+// than output channels, output channel c is the average of source channels c,
+// c + channels and so on, so stereo to mono keeps both sides. With fewer, the
+// last source channel is repeated.
+void mix_frame(const float *source, int source_channels, int channels, float *out)
+{
+    for (int channel = 0;channel < channels;++channel)
+    {
+        if (source_channels <= channels)
+        {
+            out[channel] = source[channel < source_channels ? channel : source_channels - 1];
+            continue;
+        }
+        float sum = 0.0f;
+        int count = 0;
+        for (int i = channel;i < source_channels;i += channels)
+        {
+            sum += source[i];
+            ++count;
+        }
+        out[channel] = sum / count;
+    }
+}
+
+// Mixes channels as mix_frame does and resamples linearly to the device
+// format.
+void convert_pcm(const Pcm *pcm, u32 frequency, int channels, std::vector<short> *out)
+{
+    size_t frames = pcm->samples.size() / pcm->channels;
+    size_t out_frames = frames ? (size_t)((double)frames * frequency / pcm->frequency) : 0;
+    double step = (double)pcm->frequency / frequency;
+    out->resize(out_frames * channels);
+    float a[8];
+    float b[8];
+    for (size_t frame = 0;frame < out_frames;++frame)
+    {
+        double position = frame * step;
+        size_t first = (size_t)position;
+        size_t second = first + 1 < frames ? first + 1 : first;
+        float t = (float)(position - first);
+        mix_frame(&pcm->samples[first * pcm->channels], pcm->channels, channels, a);
+        mix_frame(&pcm->samples[second * pcm->channels], pcm->channels, channels, b);
+        for (int channel = 0;channel < channels;++channel)
+        {
+            float value = (a[channel] + (b[channel] - a[channel]) * t) * 32768.0f;
+            value = value > 32767.0f ? 32767.0f : value < -32768.0f ? -32768.0f : value;
+            (*out)[frame * channels + channel] = (short)lrintf(value);
+        }
+    }
+}
+
+void write_wav(u32 frequency, int channels, const std::vector<short> &samples, std::vector<u8> *out)
+{
+    u32 data_size = (u32)(samples.size() * sizeof(short));
+    put_tag(out, "RIFF");
+    put_u32(out, WAV_HEADER_SIZE - 8 + data_size);
+    put_tag(out, "WAVE");
+    put_tag(out, "fmt ");
+    put_u32(out, 16);
+    put_u16(out, WAV_FORMAT_PCM);
+    put_u16(out, (u16)channels);
+    put_u32(out, frequency);
+    put_u32(out, frequency * channels * 2);
+    put_u16(out, (u16)(channels * 2));
+    put_u16(out, 16);
+    put_tag(out, "data");
+    put_u32(out, data_size);
+    for (short sample : samples)
+    {
+        put_u16(out, (u16)sample);
+    }
+}
+
+bool is_wav(const char *path)
+{
+    size_t length = strlen(path);
+    if (length < 4)
+    {
+        return false;
+    }
+    const char *extension = path + length - 4;
+    return extension[0] == '.' && tolower(extension[1]) == 'w' &&
+           tolower(extension[2]) == 'a' && tolower(extension[3]) == 'v';
+}
+
+struct Packed_Asset
+{
+    Asset_Entry entry;
+    std::vector<u8> data;
+};
+
+bool pack_asset(const char *spec, u32 frequency, int channels, Packed_Asset *asset)
+{
+    const char *separator = strchr(spec, '=');
+    size_t name_length = separator ? (size_t)(separator - spec) : 0;
+    if (!separator || name_length == 0 || name_length >= ASSET_NAME_SIZE)
+    {
+        fprintf(stderr, "expected name=file, got %s\n", spec);
+        return false;
+    }
+    const char *path = separator + 1;
+    memset(&asset->entry, 0, sizeof(asset->entry));
+    memcpy(asset->entry.name, spec, name_length);
+
+    Mapped_File file;
+    if (!map_file(path, &file))
+    {
+        fprintf(stderr, "cannot read %s\n", path);
+        return false;
+    }
+    if (!is_wav(path))
+    {
+        asset->entry.kind = ASSET_RAW;
+        asset->data.assign(file.data, file.data + file.size);
+        unmap_file(&file);
+        return true;
+    }
+
+    Pcm pcm;
+    const char *error = decode_wav(file.data, file.size, &pcm);
+    unmap_file(&file);
+    if (error)
+    {
+        fprintf(stderr, "%s: %s\n", path, error);
+        return false;
+    }
+    std::vector<short> samples;
+    convert_pcm(&pcm, frequency, channels, &samples);
+    write_wav(frequency, channels, samples, &asset->data);
+    asset->entry.kind = ASSET_SOUND;
+    asset->entry.frequency = frequency;
+    asset->entry.format = ASSET_AUDIO_S16LSB;
+    asset->entry.channels = (u16)channels;
+    asset->entry.samples_offset = WAV_HEADER_SIZE;
+    return true;
+}
+
+// Places every asset so that the bytes used in place, the samples of a
+// sound or the whole of anything else, start on an ASSET_ALIGNMENT boundary.
+bool write_archive(const char *path, std::vector<Packed_Asset> *assets)
+{
+    u64 offset = ASSET_HEADER_SIZE + assets->size() * sizeof(Asset_Entry);
+    for (Packed_Asset &asset : *assets)
+    {
+        u64 start = offset + asset.entry.samples_offset;
+        start = (start + ASSET_ALIGNMENT - 1) / ASSET_ALIGNMENT * ASSET_ALIGNMENT;
+        asset.entry.offset = start - asset.entry.samples_offset;
+        asset.entry.size = asset.data.size();
+        offset = asset.entry.offset + asset.entry.size;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        return false;
+    }
+    u8 header[ASSET_HEADER_SIZE] = { 'T', 'P', 'A', 'K',
+        (u8)ASSET_ARCHIVE_VERSION, (u8)(ASSET_ARCHIVE_VERSION >> 8),
+        (u8)assets->size(), (u8)(assets->size() >> 8) };
+    bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    for (const Packed_Asset &asset : *assets)
+    {
+        ok = ok && fwrite(&asset.entry, sizeof(asset.entry), 1, file) == 1;
+    }
+    u64 position = ASSET_HEADER_SIZE + assets->size() * sizeof(Asset_Entry);
+    const u8 padding[ASSET_ALIGNMENT] = {};
+    for (const Packed_Asset &asset : *assets)
+    {
+        ok = ok && fwrite(padding, 1, (size_t)(asset.entry.offset - position), file) ==
+                   asset.entry.offset - position;
+        ok = ok && fwrite(asset.data.data(), 1, asset.data.size(), file) == asset.data.size();
+        position = asset.entry.offset + asset.entry.size;
+    }
+    ok = fclose(file) == 0 && ok;
+    return ok;
+}
+
+void print_usage(const char *program)
+{
+    printf("usage: %s -o archive [-r frequency] [-c channels] name=file...\n"
+           "WAV files are decoded to 16-bit samples at the given frequency and\n"
+           "channel count, the mixer's format, which defaults to 44100 Hz stereo.\n"
+           "Extra source channels are averaged in, missing ones copied.\n"
+           "Other files are stored as they are.\n", program);
+}
+
+int main(int argc, char* argv[])
+{
+    const char *output_path = 0;
+    u32 frequency = 44100;
+    int channels = 2;
+    std::vector<const char *> specs;
+    for (int i = 1;i < argc;++i)
+    {
+        const char *arg = argv[i];
+        if (arg[0] != '-')
+        {
+            specs.push_back(arg);
+            continue;
+        }
+        const char *value = i + 1 < argc ? argv[i + 1] : 0;
+        if (!value || strlen(arg) != 2)
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+        switch (arg[1])
+        {
+        case 'o':
+            output_path = value;
+            break;
+        case 'r':
+            frequency = (u32)strtoul(value, 0, 10);
+            break;
+        case 'c':
+            channels = atoi(value);
+            break;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+        ++i;
+    }
+    if (!output_path || specs.empty() || frequency == 0 || channels < 1 || channels > 8)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<Packed_Asset> assets(specs.size());
+    for (size_t i = 0;i < specs.size();++i)
+    {
+        if (!pack_asset(specs[i], frequency, channels, &assets[i]))
+        {
+            return 1;
+        }
+    }
+    if (!write_archive(output_path, &assets))
+    {
+        fprintf(stderr, "cannot write %s\n", output_path);
+        return 1;
+    }
+    for (const Packed_Asset &asset : assets)
+    {
+        printf("%-*s %10llu bytes at %llu\n", ASSET_NAME_SIZE, asset.entry.name,
+               (unsigned long long)asset.entry.size, (unsigned long long)asset.entry.offset);
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <new>
+#include <string.h>
+#include "pool.h"
+#include "thread_pool.h"
+
+bool pool_init(Pool_Allocator *pool, size_t block_size, u32 capacity)
+{
+    memset(pool, 0, sizeof(*pool));
+    pool->block_size = (block_size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    pool->memory = (u8 *)::operator new[](pool->block_size * capacity,
+                                          std::align_val_t(CACHE_LINE_SIZE), std::nothrow);
+    if (!pool->memory)
+    {
+        return false;
+    }
+    pool->capacity = capacity;
+    for (u32 i = capacity;i > 0;--i)
+    {
+        void *block = pool->memory + (size_t)(i - 1) * pool->block_size;
+        *(void **)block = pool->free_list;
+        pool->free_list = block;
+    }
+    return true;
+}
+
+void pool_free(Pool_Allocator *pool)
+{
+    if (pool->memory)
+    {
+        ::operator delete[](pool->memory, std::align_val_t(CACHE_LINE_SIZE));
+    }
+    memset(pool, 0, sizeof(*pool));
+}
+
+void *pool_alloc(Pool_Allocator *pool)
+{
+    void *block = pool->free_list;
+    if (!block)
+    {
+        return 0;
+    }
+    pool->free_list = *(void **)block;
+    ++pool->used;
+    memset(block, 0, pool->block_size);
+    return block;
+}
+
+void pool_release(Pool_Allocator *pool, void *block)
+{
+    *(void **)block = pool->free_list;
+    pool->free_list = block;
+    --pool->used;
+}
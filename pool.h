@@ -0,0 +1,25 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include "game.h"
+
+// Fixed-size blocks carved out of one allocation up front. Blocks are
+// cache-line aligned and handed out and returned in O(1) through a free list
+// threaded through the unused blocks. Not thread-safe.
+struct Pool_Allocator
+{
+    u8 *memory;
+    size_t block_size;
+    u32 capacity;
+    u32 used;
+    void *free_list;
+};
+
+bool pool_init(Pool_Allocator *pool, size_t block_size, u32 capacity);
+void pool_free(Pool_Allocator *pool);
+// Returns a zeroed block, or 0 when every block is in use.
+void *pool_alloc(Pool_Allocator *pool);
+void pool_release(Pool_Allocator *pool, void *block);
+
+#endif
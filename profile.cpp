@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include "profile.h"
+
+const char *PROFILE_ZONE_NAMES[PROFILE_ZONE_COUNT] = {
+    "frame",
+    "events",
+    "update",
+    "render board",
+    "render piece",
+    "render text",
+    "present",
+};
+
+const char *PROFILE_COUNTER_NAMES[PROFILE_COUNTER_COUNT] = {
+    "ticks",
+    "check_piece_valid",
+    "landing row",
+    "draw calls",
+};
+
+u64 profile_time()
+{
+    return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void profiler_init(Profiler *profiler)
+{
+    memset(profiler, 0, sizeof(*profiler));
+    profiler->start_time = profile_time();
+    profiler->trace = new Profile_Trace_Event[PROFILE_TRACE_CAPACITY];
+}
+
+void profiler_free(Profiler *profiler)
+{
+    delete[] profiler->trace;
+    profiler->trace = 0;
+}
+
+void profiler_begin_frame(Profiler *profiler)
+{
+    u32 slot = profiler->frame % PROFILE_HISTORY;
+    memset(profiler->zone_times[slot], 0, sizeof(profiler->zone_times[slot]));
+    memcpy(profiler->frame_counters, profile_counters, sizeof(profiler->frame_counters));
+    profiler->frame_start = profile_time();
+}
+
+void profiler_end_frame(Profiler *profiler)
+{
+    u32 slot = profiler->frame % PROFILE_HISTORY;
+    profiler_add(profiler, PROFILE_FRAME, profiler->frame_start, profile_time());
+    for (int i = 0;i < PROFILE_COUNTER_COUNT;++i)
+    {
+        profiler->counters[slot][i] = profile_counters[i] - profiler->frame_counters[i];
+    }
+    ++profiler->frame;
+}
+
+void profiler_add(Profiler *profiler, Profile_Zone zone, u64 start, u64 end)
+{
+    if (!profiler)
+    {
+        return;
+    }
+    profiler->zone_times[profiler->frame % PROFILE_HISTORY][zone] += end - start;
+    if (profiler->trace_count < PROFILE_TRACE_CAPACITY)
+    {
+        Profile_Trace_Event *event = profiler->trace + profiler->trace_count++;
+        event->start = start;
+        event->end = end;
+        event->zone = (u8)zone;
+    }
+}
+
+int profiler_frame_count(const Profiler *profiler)
+{
+    return profiler->frame < PROFILE_HISTORY ? (int)profiler->frame : PROFILE_HISTORY - 1;
+}
+
+inline u32 history_slot(const Profiler *profiler, int age)
+{
+    return (profiler->frame - 1 - age) % PROFILE_HISTORY;
+}
+
+void profiler_zone_stats(const Profiler *profiler, Profile_Zone zone, Profile_Stats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    int count = profiler_frame_count(profiler);
+    if (count == 0)
+    {
+        return;
+    }
+    u64 times[PROFILE_HISTORY];
+    u64 sum = 0;
+    for (int i = 0;i < count;++i)
+    {
+        times[i] = profiler->zone_times[history_slot(profiler, i)][zone];
+        sum += times[i];
+    }
+    std::sort(times, times + count);
+    stats->min_ms = times[0] * 1e-6;
+    stats->avg_ms = (double)sum / count * 1e-6;
+    stats->p99_ms = times[(count - 1) * 99 / 100] * 1e-6;
+    stats->max_ms = times[count - 1] * 1e-6;
+}
+
+double profiler_counter_average(const Profiler *profiler, Profile_Counter counter)
+{
+    int count = profiler_frame_count(profiler);
+    u64 sum = 0;
+    for (int i = 0;i < count;++i)
+    {
+        sum += profiler->counters[history_slot(profiler, i)][counter];
+    }
+    return count ? (double)sum / count : 0.0;
+}
+
+bool profiler_write_csv(const Profiler *profiler, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        return false;
+    }
+    fprintf(file, "name,kind,min_ms,avg_ms,p99_ms,max_ms\n");
+    for (int zone = 0;zone < PROFILE_ZONE_COUNT;++zone)
+    {
+        Profile_Stats stats;
+        profiler_zone_stats(profiler, (Profile_Zone)zone, &stats);
+        fprintf(file, "%s,zone,%.4f,%.4f,%.4f,%.4f\n", PROFILE_ZONE_NAMES[zone],
+                stats.min_ms, stats.avg_ms, stats.p99_ms, stats.max_ms);
+    }
+    for (int counter = 0;counter < PROFILE_COUNTER_COUNT;++counter)
+    {
+        fprintf(file, "%s,counter per frame,,%.2f,,\n", PROFILE_COUNTER_NAMES[counter],
+                profiler_counter_average(profiler, (Profile_Counter)counter));
+    }
+    bool ok = !ferror(file);
+    return fclose(file) == 0 && ok;
+}
+
+bool profiler_write_trace(const Profiler *profiler, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        return false;
+    }
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (u32 i = 0;i < profiler->trace_count;++i)
+    {
+        const Profile_Trace_Event *event = profiler->trace + i;
+        fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                "\"ts\":%.3f,\"dur\":%.3f}\n", i ? "," : "",
+                PROFILE_ZONE_NAMES[event->zone],
+                (event->start - profiler->start_time) * 1e-3,
+                (event->end - event->start) * 1e-3);
+    }
+    fprintf(file, "]}\n");
+    bool ok = !ferror(file);
+    return fclose(file) == 0 && ok;
+}
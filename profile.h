@@ -0,0 +1,114 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "game.h"
+
+#define PROFILE_HISTORY 256
+#define PROFILE_TRACE_CAPACITY (1 << 16)
+
+enum Profile_Zone
+{
+    PROFILE_FRAME,
+    PROFILE_EVENTS,
+    PROFILE_UPDATE,
+    PROFILE_RENDER_BOARD,
+    PROFILE_RENDER_PIECE,
+    PROFILE_RENDER_TEXT,
+    PROFILE_PRESENT,
+    PROFILE_ZONE_COUNT
+};
+
+enum Profile_Counter
+{
+    PROFILE_COUNTER_TICKS,
+    PROFILE_COUNTER_CHECK_PIECE_VALID,
+    PROFILE_COUNTER_LANDING_ROW,
+    PROFILE_COUNTER_DRAW_CALLS,
+    PROFILE_COUNTER_COUNT
+};
+
+extern const char *PROFILE_ZONE_NAMES[PROFILE_ZONE_COUNT];
+extern const char *PROFILE_COUNTER_NAMES[PROFILE_COUNTER_COUNT];
+
+// Hot-path call counts. Each thread counts into its own copy, and the
+// profiler reads the copy of the thread that calls profiler_end_frame.
+inline thread_local u64 profile_counters[PROFILE_COUNTER_COUNT];
+
+#define PROFILE_COUNT(counter) (++profile_counters[counter])
+
+// Counts inside the simulation core, which every headless tool runs too, so
+// they cost nothing unless the core is built with PROFILE_CORE_COUNTERS.
+#ifdef PROFILE_CORE_COUNTERS
+#define PROFILE_CORE_COUNT(counter) PROFILE_COUNT(counter)
+#else
+#define PROFILE_CORE_COUNT(counter) ((void)0)
+#endif
+
+struct Profile_Trace_Event
+{
+    u64 start;
+    u64 end;
+    u8 zone;
+};
+
+// Zone times are summed per frame, and statistics cover the most recent
+// frames that fit in the history. The trace keeps every zone interval until
+// it fills up.
+struct Profiler
+{
+    u64 start_time;
+    u64 frame_start;
+    u64 zone_times[PROFILE_HISTORY][PROFILE_ZONE_COUNT];
+    u64 counters[PROFILE_HISTORY][PROFILE_COUNTER_COUNT];
+    u64 frame_counters[PROFILE_COUNTER_COUNT];
+    u32 frame;
+    Profile_Trace_Event *trace;
+    u32 trace_count;
+};
+
+struct Profile_Stats
+{
+    double min_ms;
+    double avg_ms;
+    double p99_ms;
+    double max_ms;
+};
+
+u64 profile_time();
+
+void profiler_init(Profiler *profiler);
+void profiler_free(Profiler *profiler);
+void profiler_begin_frame(Profiler *profiler);
+void profiler_end_frame(Profiler *profiler);
+// Does nothing when profiler is null.
+void profiler_add(Profiler *profiler, Profile_Zone zone, u64 start, u64 end);
+
+int profiler_frame_count(const Profiler *profiler);
+void profiler_zone_stats(const Profiler *profiler, Profile_Zone zone, Profile_Stats *stats);
+double profiler_counter_average(const Profiler *profiler, Profile_Counter counter);
+
+bool profiler_write_csv(const Profiler *profiler, const char *path);
+bool profiler_write_trace(const Profiler *profiler, const char *path);
+
+struct Profile_Scope
+{
+    Profiler *profiler;
+    Profile_Zone zone;
+    u64 start;
+
+    Profile_Scope(Profiler *profiler, Profile_Zone zone)
+        : profiler(profiler), zone(zone), start(profile_time())
+    {
+    }
+    ~Profile_Scope()
+    {
+        profiler_add(profiler, zone, start, profile_time());
+    }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(profiler, zone) \
+    Profile_Scope PROFILE_CONCAT(profile_scope_, __LINE__)(profiler, zone)
+
+#endif
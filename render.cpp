@@ -0,0 +1,539 @@
+#include <stdio.h>
+#include <string.h>
+#include "render.h"
+
+typedef struct Color
+{
+    u8 r,g,b,a;
+} Color;
+
+inline Color
+color(u8 r, u8 g, u8 b, u8 a)
+{
+    Color result;
+    result.r = r;
+    result.g = g;
+    result.b = b;
+    result.a = a;
+    return result;
+}
+const Color BASE_COLORS[] = {
+    color(0x28, 0x28, 0x28, 0xFF),
+    color(0x2D, 0x99, 0x99, 0xFF),
+    color(0x99, 0x99, 0x2D, 0xFF),
+    color(0x99, 0x2D, 0x99, 0xFF),
+    color(0x2D, 0x99, 0x51, 0xFF),
+    color(0x99, 0x2D, 0x2D, 0xFF),
+    color(0x2D, 0x63, 0x99, 0xFF),
+    color(0x99, 0x63, 0x2D, 0xFF)
+};
+
+const Color LIGHT_COLORS[] = {
+    color(0x28, 0x28, 0x28, 0xFF),
+    color(0x44, 0xE5, 0xE5, 0xFF),
+    color(0xE5, 0xE5, 0x44, 0xFF),
+    color(0xE5, 0x44, 0xE5, 0xFF),
+    color(0x44, 0xE5, 0x7A, 0xFF),
+    color(0xE5, 0x44, 0x44, 0xFF),
+    color(0x44, 0x95, 0xE5, 0xFF),
+    color(0xE5, 0x95, 0x44, 0xFF)
+};
+
+const Color DARK_COLORS[] = {
+    color(0x28, 0x28, 0x28, 0xFF),
+    color(0x1E, 0x66, 0x66, 0xFF),
+    color(0x66, 0x66, 0x1E, 0xFF),
+    color(0x66, 0x1E, 0x66, 0xFF),
+    color(0x1E, 0x66, 0x36, 0xFF),
+    color(0x66, 0x1E, 0x1E, 0xFF),
+    color(0x1E, 0x42, 0x66, 0xFF),
+    color(0x66, 0x42, 0x1E, 0xFF)
+};
+
+void fill_rect(SDL_Renderer *renderer , int x , int y , int width, int height, Color color)
+{
+    SDL_Rect rect = {};
+    rect.x = x;
+    rect.y = y;
+    rect.w = width;
+    rect.h = height;
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    SDL_RenderFillRect(renderer, &rect);
+    PROFILE_COUNT(PROFILE_COUNTER_DRAW_CALLS);
+}
+
+void draw_rect(SDL_Renderer *renderer,
+          int x, int y, int width, int height, Color color)
+{
+    SDL_Rect rect = {};
+    rect.x = x;
+    rect.y = y;
+    rect.w = width;
+    rect.h = height;
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    SDL_RenderDrawRect(renderer, &rect);
+    PROFILE_COUNT(PROFILE_COUNTER_DRAW_CALLS);
+}
+
+#define COLOR_COUNT ARRAY_COUNT(BASE_COLORS)
+#define CELL_BATCH_CAPACITY (WIDTH * HEIGHT + 8)
+
+enum Cell_Layer
+{
+    CELL_LAYER_DARK,
+    CELL_LAYER_LIGHT,
+    CELL_LAYER_BASE,
+    CELL_LAYER_OUTLINE,
+    CELL_LAYER_COUNT
+};
+
+// Cells are gathered per color and layer and drawn with one
+// SDL_RenderFillRects call each, so the number of draw calls does not depend
+// on how many cells are on screen. Cells never overlap, so drawing every
+// dark rect before every light rect looks the same as drawing cell by cell.
+struct Cell_Batch
+{
+    SDL_Rect rects[CELL_LAYER_COUNT][COLOR_COUNT][CELL_BATCH_CAPACITY];
+    int counts[CELL_LAYER_COUNT][COLOR_COUNT];
+};
+
+inline void cell_batch_push(Cell_Batch *batch, Cell_Layer layer, u8 value,
+                            int x, int y, int width, int height)
+{
+    int *count = &batch->counts[layer][value];
+    if (*count < CELL_BATCH_CAPACITY)
+    {
+        batch->rects[layer][value][(*count)++] = SDL_Rect { x, y, width, height };
+    }
+}
+
+void draw_cell(Cell_Batch *batch,
+          int row, int col, u8 value,
+          int offset_x, int offset_y,
+          bool outline = false)
+{
+    int edge = GRID_SIZE / 8;
+
+    int x = col * GRID_SIZE + offset_x;
+    int y = row * GRID_SIZE + offset_y;
+
+    if (outline)
+    {
+        cell_batch_push(batch, CELL_LAYER_OUTLINE, value, x, y, GRID_SIZE, GRID_SIZE);
+        return;
+    }
+    cell_batch_push(batch, CELL_LAYER_DARK, value, x, y, GRID_SIZE, GRID_SIZE);
+    cell_batch_push(batch, CELL_LAYER_LIGHT, value, x + edge, y,
+                    GRID_SIZE - edge, GRID_SIZE - edge);
+    cell_batch_push(batch, CELL_LAYER_BASE, value, x + edge, y + edge,
+                    GRID_SIZE - edge * 2, GRID_SIZE - edge * 2);
+}
+
+void flush_cells(SDL_Renderer *renderer, Cell_Batch *batch)
+{
+    const Color *layer_colors[CELL_LAYER_COUNT] = {
+        DARK_COLORS, LIGHT_COLORS, BASE_COLORS, BASE_COLORS
+    };
+    for (int layer = 0;layer < CELL_LAYER_COUNT;++layer)
+    {
+        for (int value = 0;value < (int)COLOR_COUNT;++value)
+        {
+            int count = batch->counts[layer][value];
+            if (count == 0)
+            {
+                continue;
+            }
+            Color color = layer_colors[layer][value];
+            SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+            if (layer == CELL_LAYER_OUTLINE)
+            {
+                SDL_RenderDrawRects(renderer, batch->rects[layer][value], count);
+            }
+            else
+            {
+                SDL_RenderFillRects(renderer, batch->rects[layer][value], count);
+            }
+            batch->counts[layer][value] = 0;
+            PROFILE_COUNT(PROFILE_COUNTER_DRAW_CALLS);
+        }
+    }
+}
+
+void draw_piece(Cell_Batch *batch,
+           const Piece_State *piece,
+           int offset_x, int offset_y,
+           bool outline = false)
+{
+    const Tetrino_Shape *shape = tetrino_shape(piece->tetrino_index, piece->rotation);
+    for (int cell = 0;cell < 4;++cell)
+    {
+        draw_cell(batch,
+                  shape->cell_row[cell] + piece->offset_row,
+                  shape->cell_col[cell] + piece->offset_col,
+                  shape->value,
+                  offset_x, offset_y,
+                  outline);
+    }
+}
+SDL_Texture *cell_atlas_create(Render_Context *context)
+{
+    SDL_Renderer *renderer = context->renderer;
+    SDL_Texture *atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                                           SDL_TEXTUREACCESS_TARGET,
+                                           CELL_ATLAS_SLOTS * GRID_SIZE, GRID_SIZE);
+    if (!atlas)
+    {
+        return 0;
+    }
+    SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderTarget(renderer, atlas);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+    for (int value = 0;value < (int)COLOR_COUNT;++value)
+    {
+        draw_cell(context->cells, 0, value, value, 0, 0);
+        draw_cell(context->cells, 0, CELL_ATLAS_OUTLINE + value, value, 0, 0, true);
+    }
+    flush_cells(renderer, context->cells);
+    SDL_SetRenderTarget(renderer, 0);
+    return atlas;
+}
+
+template <int W, int H>
+bool board_texture_create(Board_Texture<W, H> *board_texture, SDL_Renderer *renderer)
+{
+    board_texture->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                                               SDL_TEXTUREACCESS_TARGET,
+                                               W * GRID_SIZE, H * GRID_SIZE);
+    board_texture->valid = false;
+    return board_texture->texture != 0;
+}
+
+template <int W, int H>
+void board_texture_free(Board_Texture<W, H> *board_texture)
+{
+    if (board_texture->texture)
+    {
+        SDL_DestroyTexture(board_texture->texture);
+        board_texture->texture = 0;
+    }
+}
+
+// Flushes often enough that a wide board never overflows the cell batch.
+template <int W>
+void draw_board_rows(SDL_Renderer *renderer, Cell_Batch *batch,
+                     const u8 *board, int first_row, int row_count,
+                     int offset_x, int offset_y)
+{
+    constexpr int rows_per_flush = W < CELL_BATCH_CAPACITY ? CELL_BATCH_CAPACITY / W : 1;
+    fill_rect(renderer, offset_x, offset_y + first_row * GRID_SIZE,
+              W * GRID_SIZE, row_count * GRID_SIZE,
+              BASE_COLORS[0]);
+    for (int row = first_row;row < first_row + row_count;++row)
+    {
+        for (int col = 0;col < W;++col)
+        {
+            u8 value = matrix_get(board, W, row, col);
+            if (value)
+            {
+                draw_cell(batch, row, col, value, offset_x, offset_y);
+            }
+        }
+        if ((row - first_row + 1) % rows_per_flush == 0)
+        {
+            flush_cells(renderer, batch);
+        }
+    }
+    flush_cells(renderer, batch);
+}
+
+template <int W, int H>
+void board_texture_update(Board_Texture<W, H> *board_texture, SDL_Renderer *renderer,
+                          Cell_Batch *batch, const u8 *board)
+{
+    bool target_set = false;
+    for (int row = 0;row < H;)
+    {
+        int end = row;
+        while (end < H &&
+               (!board_texture->valid ||
+                memcmp(board + end * W, board_texture->board + end * W, W) != 0))
+        {
+            ++end;
+        }
+        if (end == row)
+        {
+            ++row;
+            continue;
+        }
+        if (!target_set)
+        {
+            SDL_SetRenderTarget(renderer, board_texture->texture);
+            target_set = true;
+        }
+        draw_board_rows<W>(renderer, batch, board, row, end - row, 0, 0);
+        row = end;
+    }
+    if (target_set)
+    {
+        SDL_SetRenderTarget(renderer, 0);
+    }
+    memcpy(board_texture->board, board, sizeof(board_texture->board));
+    board_texture->valid = true;
+}
+
+template <int W, int H>
+void draw_board(SDL_Renderer *renderer, Cell_Batch *batch,
+                Board_Texture<W, H> *board_texture, const Board<W, H> *board,
+                int offset_x, int offset_y)
+{
+    if (!board_texture->texture)
+    {
+        draw_board_rows<W>(renderer, batch, board->cells, 0, H, offset_x, offset_y);
+        return;
+    }
+    board_texture_update(board_texture, renderer, batch, board->cells);
+    SDL_Rect rect = { offset_x, offset_y, W * GRID_SIZE, H * GRID_SIZE };
+    SDL_RenderCopy(renderer, board_texture->texture, 0, &rect);
+    PROFILE_COUNT(PROFILE_COUNTER_DRAW_CALLS);
+}
+
+void render_profile(Render_Context *context)
+{
+    SDL_Renderer *renderer = context->renderer;
+    const Glyph_Atlas *atlas = &context->text.atlas;
+    const Profiler *profiler = context->profiler;
+    SDL_Color text_color = { 0xFF, 0xFF, 0xFF, 0xFF };
+    int line_height = atlas->height;
+    int columns[] = { 240, 320, 400, 470 };
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    fill_rect(renderer, 0, 100, WINDOW_WIDTH, (PROFILE_ZONE_COUNT + PROFILE_COUNTER_COUNT + 2) * line_height,
+              color(0x00, 0x00, 0x00, 0xC0));
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+    char buffer[64];
+    int y = 105;
+    const char *headers[] = { "MIN", "AVG", "P99", "MAX" };
+    draw_string(renderer, atlas, "MS", 10, y, TEXT_ALIGN_LEFT, text_color);
+    for (int i = 0;i < 4;++i)
+    {
+        draw_string(renderer, atlas, headers[i], columns[i], y, TEXT_ALIGN_RIGHT, text_color);
+    }
+    for (int zone = 0;zone < PROFILE_ZONE_COUNT;++zone)
+    {
+        y += line_height;
+        Profile_Stats stats;
+        profiler_zone_stats(profiler, (Profile_Zone)zone, &stats);
+        double values[] = { stats.min_ms, stats.avg_ms, stats.p99_ms, stats.max_ms };
+        draw_string(renderer, atlas, PROFILE_ZONE_NAMES[zone], 10, y, TEXT_ALIGN_LEFT, text_color);
+        for (int i = 0;i < 4;++i)
+        {
+            snprintf(buffer, sizeof(buffer), "%.2f", values[i]);
+            draw_string(renderer, atlas, buffer, columns[i], y, TEXT_ALIGN_RIGHT, text_color);
+        }
+    }
+    y += line_height;
+    for (int counter = 0;counter < PROFILE_COUNTER_COUNT;++counter)
+    {
+        y += line_height;
+        snprintf(buffer, sizeof(buffer), "%.1f",
+                 profiler_counter_average(profiler, (Profile_Counter)counter));
+        draw_string(renderer, atlas, PROFILE_COUNTER_NAMES[counter], 10, y, TEXT_ALIGN_LEFT, text_color);
+        draw_string(renderer, atlas, buffer, columns[1], y, TEXT_ALIGN_RIGHT, text_color);
+    }
+}
+
+const char *CLEAR_EFFECTS[] = { "SINGLE", "DOUBLE", "TRIPLE", "TETRIS" };
+
+void update_effects(Render_Context *context)
+{
+    if (!context->events)
+    {
+        return;
+    }
+    Event_Record event;
+    while (event_ring_pop(context->events, &context->event_cursor, &event))
+    {
+        if (event.type == GAME_EVENT_LINE_CLEAR && event.cleared_count > 0)
+        {
+            int index = event.cleared_count < 4 ? event.cleared_count - 1 : 3;
+            context->clear_effect = { CLEAR_EFFECTS[index], 0, (int)event.tick };
+        }
+        else if (event.type == GAME_EVENT_LEVEL_UP)
+        {
+            context->level_effect = { "LEVEL %d", event.level, (int)event.tick };
+        }
+        else if (event.type == GAME_EVENT_GAME_START)
+        {
+            context->clear_effect.format = 0;
+            context->level_effect.format = 0;
+        }
+    }
+}
+
+void render_effect(SDL_Renderer *renderer, const Glyph_Atlas *atlas, Text_Label *label,
+                   const Event_Effect *effect, int time, int y)
+{
+    int age = time - effect->tick;
+    if (!effect->format || age < 0 || age >= EFFECT_TICKS)
+    {
+        return;
+    }
+    SDL_Color effect_color = { 0xFF, 0xD7, 0x28, (u8)(0xFF * (EFFECT_TICKS - age) / EFFECT_TICKS) };
+    draw_label(renderer, atlas, label, effect->format, effect->value,
+               WIDTH * GRID_SIZE / 2, y, TEXT_ALIGN_CENTER, effect_color);
+}
+
+void render_hud(const Game_State *game, Render_Context *context, int margin_y)
+{
+    PROFILE_SCOPE(context->profiler, PROFILE_RENDER_TEXT);
+    SDL_Renderer *renderer = context->renderer;
+    Hud_Text *text = &context->text;
+    const Glyph_Atlas *atlas = &text->atlas;
+    SDL_Color text_color = { 0x28, 0xFF, 0xFF, 0xFF };
+
+    if (game->phase == GAME_GAMEOVER)
+    {
+        int x = WIDTH * GRID_SIZE / 2;
+        int y = (HEIGHT * GRID_SIZE + margin_y) / 2;
+        draw_string(renderer, atlas, "GAME OVER ",
+                    x, y, TEXT_ALIGN_CENTER, text_color);
+        draw_string(renderer, atlas, "PLAY AGAIN!!!",
+                    x, y+40, TEXT_ALIGN_CENTER, text_color);
+        draw_label(renderer, atlas, &text->final_score,
+                   game->score >= game->points ? "SCORE: %d" : "HIGHT SCORE: %d",
+                   game->points, x, y-30, TEXT_ALIGN_CENTER, text_color);
+    }
+    else if (game->phase == GAME_START)
+    {
+        int x = WIDTH * GRID_SIZE / 2;
+        int y = (HEIGHT * GRID_SIZE + margin_y) / 2;
+        draw_string(renderer, atlas, "PRESS START",
+                    x, y-30, TEXT_ALIGN_CENTER, text_color);
+        draw_string(renderer, atlas, "!!GOOD LUCK!!",
+                    x, y, TEXT_ALIGN_CENTER, text_color);
+        draw_label(renderer, atlas, &text->start_level, "STARTING LEVEL: %d",
+                   game->start_level, x, y + 30, TEXT_ALIGN_CENTER, text_color);
+    }
+    fill_rect(renderer,0, margin_y,
+              WIDTH * GRID_SIZE, (HEIGHT - REAL_HEIGHT) * GRID_SIZE,
+              color(0x00, 0x00, 0x00, 0x00));
+
+    draw_label(renderer, atlas, &text->level, "LEVEL: %d",
+               game->level, 50, 5, TEXT_ALIGN_LEFT, text_color);
+    draw_label(renderer, atlas, &text->lines, "LINES: %d",
+               game->line_count, 50, 35, TEXT_ALIGN_LEFT, text_color);
+    draw_label(renderer, atlas, &text->points, "POINTS: %d",
+               game->points, 50, 65, TEXT_ALIGN_LEFT, text_color);
+    draw_label(renderer, atlas, &text->high_score, "HIGH SCORE: %d",
+               game->score, 200, 5, TEXT_ALIGN_LEFT, text_color);
+
+    render_effect(renderer, atlas, &text->clear_effect, &context->clear_effect,
+                  game->time, margin_y + HEIGHT * GRID_SIZE / 3);
+    render_effect(renderer, atlas, &text->level_effect, &context->level_effect,
+                  game->time, margin_y + HEIGHT * GRID_SIZE / 3 + 30);
+
+    if (context->show_profile)
+    {
+        render_profile(context);
+    }
+}
+
+// alpha is how far the clock is between game->time and the next tick. The
+// falling piece is drawn that far toward the row gravity moves it to next.
+void render_pieces(const Game_State *game, float alpha, Render_Context *context,
+                   int margin_y)
+{
+    PROFILE_SCOPE(context->profiler, PROFILE_RENDER_PIECE);
+    SDL_Renderer *renderer = context->renderer;
+    Cell_Batch *cells = context->cells;
+    Color highlight_color = color(0x28, 0xFF, 0xFF, 0xFF);
+
+    if (game->phase == GAME_PLAY)
+    {
+        int fall_y = 0;
+        if (game->time + 1 >= game->next_drop_time &&
+            game->piece.offset_row < game->landing_row)
+        {
+            fall_y = (int)(alpha * GRID_SIZE);
+        }
+        draw_piece(cells, &game->piece, 0, margin_y + fall_y);
+
+        Piece_State piece = game->piece;
+        piece.offset_row = game->landing_row;
+
+        draw_piece(cells, &piece, 0, margin_y, true);
+    }
+    flush_cells(renderer, cells);
+
+    if (game->phase == GAME_LINE)
+    {
+        for (int row = 0;row < HEIGHT;++row)
+        {
+            if (game->lines[row])
+            {
+                int x = 0;
+                int y = row * GRID_SIZE + margin_y;
+
+                fill_rect(renderer, x, y,
+                          WIDTH * GRID_SIZE, GRID_SIZE, highlight_color);
+            }
+        }
+    }
+}
+
+void render_game(const Game_State *game , float alpha, Render_Context *context)
+{
+    int margin_y = 60;
+    update_effects(context);
+    {
+        PROFILE_SCOPE(context->profiler, PROFILE_RENDER_BOARD);
+        draw_board(context->renderer, context->cells, &context->board_texture,
+                   &game->board, 0, margin_y);
+    }
+    render_pieces(game, alpha, context, margin_y);
+    render_hud(game, context, margin_y);
+}
+bool render_context_init(Render_Context *context, SDL_Renderer *renderer,
+                         TTF_Font *font, Profiler *profiler)
+{
+    memset(context, 0, sizeof(*context));
+    context->renderer = renderer;
+    context->font = font;
+    context->profiler = profiler;
+    context->cells = new Cell_Batch();
+    board_texture_create(&context->board_texture, renderer);
+    return !font || glyph_atlas_create(&context->text.atlas, renderer, font);
+}
+
+void render_context_free(Render_Context *context)
+{
+    glyph_atlas_free(&context->text.atlas);
+    board_texture_free(&context->board_texture);
+    delete context->cells;
+    context->cells = 0;
+}
+
+void render_context_listen(Render_Context *context, Event_Ring *events)
+{
+    context->events = events;
+    event_cursor_init(events, &context->event_cursor);
+}
+
+void render_context_reset(Render_Context *context, bool device_lost)
+{
+    if (device_lost)
+    {
+        board_texture_free(&context->board_texture);
+        board_texture_create(&context->board_texture, context->renderer);
+        // Clearing the labels drops their layouts along with the old atlas.
+        glyph_atlas_free(&context->text.atlas);
+        memset(&context->text, 0, sizeof(context->text));
+        if (context->font)
+        {
+            glyph_atlas_create(&context->text.atlas, context->renderer, context->font);
+        }
+    }
+    context->board_texture.valid = false;
+}
@@ -0,0 +1,89 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "SDL.h"
+#include "SDL_ttf.h"
+#include "event_ring.h"
+#include "game.h"
+#include "profile.h"
+#include "text.h"
+
+#define GRID_SIZE 30
+#define WINDOW_WIDTH 480
+#define WINDOW_HEIGHT 720
+#define EFFECT_TICKS TICKS_PER_SECOND
+
+struct Hud_Text
+{
+    Glyph_Atlas atlas;
+    Text_Label level;
+    Text_Label lines;
+    Text_Label points;
+    Text_Label high_score;
+    Text_Label final_score;
+    Text_Label start_level;
+    Text_Label clear_effect;
+    Text_Label level_effect;
+};
+
+// A callout over the board that fades out over EFFECT_TICKS from the tick of
+// the event that set it. format takes value, if anything.
+struct Event_Effect
+{
+    const char *format;
+    int value;
+    int tick;
+};
+
+// The settled cells live in a render target texture. Only rows that differ
+// from the copy of the board it was last drawn from are redrawn, so a lock
+// touches a few rows and a clear redraws the rows that shifted down.
+template <int W, int H>
+struct Board_Texture
+{
+    SDL_Texture *texture;
+    u8 board[W * H];
+    bool valid;
+};
+
+struct Cell_Batch;
+
+struct Render_Context
+{
+    SDL_Renderer *renderer;
+    // Kept to rebuild the glyph atlas when the device is lost.
+    TTF_Font *font;
+    Cell_Batch *cells;
+    Board_Texture<WIDTH, HEIGHT> board_texture;
+    Hud_Text text;
+    Profiler *profiler;
+    bool show_profile;
+    // Set by render_context_listen. render_game reads the events pushed since
+    // the last frame into the effects.
+    Event_Ring *events;
+    Event_Cursor event_cursor;
+    Event_Effect clear_effect;
+    Event_Effect level_effect;
+};
+
+bool render_context_init(Render_Context *context, SDL_Renderer *renderer,
+                         TTF_Font *font, Profiler *profiler);
+void render_context_free(Render_Context *context);
+// Call on SDL_RENDER_TARGETS_RESET (device_lost false) or
+// SDL_RENDER_DEVICE_RESET (device_lost true).
+void render_context_reset(Render_Context *context, bool device_lost);
+// Shows line clears and level ups from events pushed after this call.
+void render_context_listen(Render_Context *context, Event_Ring *events);
+
+void render_game(const Game_State *game , float alpha, Render_Context *context);
+// Frame time overlay, drawn by render_game when show_profile is set.
+void render_profile(Render_Context *context);
+
+// One GRID_SIZE sprite per cell color, side by side: slot value is a settled
+// cell and slot CELL_ATLAS_OUTLINE + value the outline of a landing piece.
+// Slot 0 is the empty cell. Returns 0 when render targets are unsupported.
+#define CELL_ATLAS_OUTLINE 8
+#define CELL_ATLAS_SLOTS 16
+SDL_Texture *cell_atlas_create(Render_Context *context);
+
+#endif
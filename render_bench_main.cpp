@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "render.h"
+
+struct Render_Bench
+{
+    SDL_Surface *surface;
+    SDL_Renderer *renderer;
+    Render_Context context;
+};
+
+u64 surface_hash(const SDL_Surface *surface)
+{
+    u64 hash = 0;
+    for (int row = 0;row < surface->h;++row)
+    {
+        const u32 *pixels = (const u32 *)((const u8 *)surface->pixels + row * surface->pitch);
+        for (int col = 0;col < surface->w;col += 8)
+        {
+            hash = hash * 31 + pixels[col];
+        }
+    }
+    return hash;
+}
+
+u64 render_fixtures(const Bench_Fixtures *fixtures, Render_Bench *bench,
+                    bool full_redraw, u64 *checksum)
+{
+    SDL_Renderer *renderer = bench->renderer;
+    for (int i = 0;i < fixtures->count;++i)
+    {
+        if (full_redraw)
+        {
+            bench->context.board_texture.valid = false;
+        }
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        SDL_RenderClear(renderer);
+        render_game(fixtures->states + i, 0.5f, &bench->context);
+        SDL_RenderPresent(renderer);
+    }
+    *checksum = bench_mix(*checksum, surface_hash(bench->surface));
+    return fixtures->count;
+}
+
+void invalidate_board(const Bench_Fixtures *, void *user)
+{
+    Render_Bench *bench = (Render_Bench *)user;
+    bench->context.board_texture.valid = false;
+}
+
+u64 bench_render_game(const Bench_Fixtures *fixtures, void *user, u64 *checksum)
+{
+    return render_fixtures(fixtures, (Render_Bench *)user, false, checksum);
+}
+
+u64 bench_render_game_full(const Bench_Fixtures *fixtures, void *user, u64 *checksum)
+{
+    return render_fixtures(fixtures, (Render_Bench *)user, true, checksum);
+}
+
+const Bench_Case BENCH_CASES[] = {
+    { "render_game", invalidate_board, bench_render_game },
+    { "render_game_full_redraw", 0, bench_render_game_full },
+};
+
+void print_usage(const char *program)
+{
+    printf("usage: %s [-s seed] [-n fixtures] [-t min_ms_per_sample]\n"
+           "          [-F font_file] [-o csv_file]\n", program);
+}
+
+int main(int argc, char* argv[])
+{
+    u64 seed = 1;
+    int fixture_count = 256;
+    int min_ms = 100;
+    const char *font_name = "font__.ttf";
+    const char *output_path = 0;
+
+    for (int i = 1;i < argc;++i)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : 0;
+        if (!value || arg[0] != '-' || strlen(arg) != 2)
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+        switch (arg[1])
+        {
+        case 's':
+            seed = strtoull(value, 0, 10);
+            break;
+        case 'n':
+            fixture_count = atoi(value);
+            break;
+        case 't':
+            min_ms = atoi(value);
+            break;
+        case 'F':
+            font_name = value;
+            break;
+        case 'o':
+            output_path = value;
+            break;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+        ++i;
+    }
+    if (fixture_count <= 0 || min_ms <= 0)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // The software renderer draws into a plain surface, so this runs
+    // without a window or a display.
+    if (SDL_Init(0) < 0 || TTF_Init() < 0)
+    {
+        fprintf(stderr, "cannot initialize SDL: %s\n", SDL_GetError());
+        return 1;
+    }
+    Render_Bench *bench = new Render_Bench;
+    bench->surface = SDL_CreateRGBSurfaceWithFormat(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32,
+                                                    SDL_PIXELFORMAT_ARGB8888);
+    bench->renderer = bench->surface ? SDL_CreateSoftwareRenderer(bench->surface) : 0;
+    if (!bench->renderer)
+    {
+        fprintf(stderr, "cannot create software renderer: %s\n", SDL_GetError());
+        return 1;
+    }
+    TTF_Font *font = TTF_OpenFont(font_name, 24);
+    if (!font)
+    {
+        fprintf(stderr, "cannot open %s, text is not drawn\n", font_name);
+    }
+    if (!render_context_init(&bench->context, bench->renderer, font, 0))
+    {
+        fprintf(stderr, "cannot build glyph atlas: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    FILE *output = output_path ? fopen(output_path, "w") : stdout;
+    if (!output)
+    {
+        fprintf(stderr, "cannot write %s\n", output_path);
+        return 1;
+    }
+
+    Bench_Fixtures fixtures;
+    bench_make_fixtures(&fixtures, seed, fixture_count);
+    bench_print_header(output);
+    for (int i = 0;i < (int)ARRAY_COUNT(BENCH_CASES);++i)
+    {
+        Bench_Result result;
+        bench_run(BENCH_CASES + i, &fixtures, bench, (u64)min_ms * 1000000, &result);
+        bench_print_result(output, &result);
+    }
+    bench_free_fixtures(&fixtures);
+    if (output != stdout)
+    {
+        fclose(output);
+    }
+
+    render_context_free(&bench->context);
+    if (font)
+    {
+        TTF_CloseFont(font);
+    }
+    SDL_DestroyRenderer(bench->renderer);
+    SDL_FreeSurface(bench->surface);
+    delete bench;
+    TTF_Quit();
+    SDL_Quit();
+    return 0;
+}
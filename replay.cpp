@@ -0,0 +1,280 @@
+#include <string.h>
+#include "mapped_file.h"
+#include "replay.h"
+
+void write_bytes(Replay_Writer *writer, const u8 *data, size_t size)
+{
+    writer->checksum = fnv1a(writer->checksum, data, size);
+    fwrite(data, 1, size, writer->file);
+}
+
+void write_u32(Replay_Writer *writer, u32 value)
+{
+    u8 bytes[4] = { (u8)value, (u8)(value >> 8), (u8)(value >> 16), (u8)(value >> 24) };
+    write_bytes(writer, bytes, sizeof(bytes));
+}
+
+void write_varint(Replay_Writer *writer, u64 value)
+{
+    u8 bytes[10];
+    int count = 0;
+    do
+    {
+        u8 byte = value & 0x7F;
+        value >>= 7;
+        bytes[count++] = value ? (u8)(byte | 0x80) : byte;
+    } while (value);
+    write_bytes(writer, bytes, count);
+}
+
+void emit_event(Replay_Writer *writer, u32 tick, u8 keys, Replay_Event_Kind kind)
+{
+    u64 delta = tick - writer->last_event_tick;
+    write_varint(writer, (delta << 7) | (kind << 5) | keys);
+    writer->last_event_tick = tick;
+    ++writer->event_count;
+}
+
+void flush_pending(Replay_Writer *writer)
+{
+    if (writer->has_pending)
+    {
+        emit_event(writer, writer->pending_tick, writer->pending_keys, REPLAY_EVENT_TOGGLE);
+        writer->has_pending = false;
+    }
+}
+
+bool replay_writer_open(Replay_Writer *writer, const char *path, const Game_State *game)
+{
+    memset(writer, 0, sizeof(*writer));
+    writer->file = fopen(path, "wb");
+    if (!writer->file)
+    {
+        return false;
+    }
+    writer->checksum = FNV_OFFSET;
+    u8 header[REPLAY_HEADER_SIZE] = { 'T', 'R', 'P', 'L', REPLAY_VERSION, 0, 0, 0 };
+    for (int i = 0;i < 8;++i)
+    {
+        header[8 + i] = (u8)(game->seed >> (8 * i));
+    }
+    header[16] = (u8)game->randomizer;
+    header[18] = (u8)game->start_level;
+    header[19] = (u8)(game->start_level >> 8);
+    header[20] = (u8)game->das;
+    header[21] = (u8)game->arr;
+    write_bytes(writer, header, sizeof(header));
+    return true;
+}
+
+void replay_writer_tick(Replay_Writer *writer, const Input_State *input)
+{
+    u8 held = input_held_keys(input);
+    u8 changed = held ^ writer->held;
+    u8 extra = input_pressed_keys(input) & ~(held & ~writer->held);
+    if (changed && writer->has_pending)
+    {
+        bool was_press = (writer->pending_held & writer->pending_keys) == 0;
+        if (was_press && writer->tick == writer->pending_tick + 1 &&
+            changed == writer->pending_keys)
+        {
+            emit_event(writer, writer->pending_tick, changed, REPLAY_EVENT_TAP);
+            writer->has_pending = false;
+            changed = 0;
+        }
+    }
+    if (changed || extra)
+    {
+        flush_pending(writer);
+    }
+    if (extra)
+    {
+        emit_event(writer, writer->tick, extra, REPLAY_EVENT_PRESS);
+    }
+    if (changed)
+    {
+        writer->has_pending = true;
+        writer->pending_tick = writer->tick;
+        writer->pending_keys = changed;
+        writer->pending_held = writer->held;
+    }
+    writer->held = held;
+    ++writer->tick;
+}
+
+bool replay_writer_close(Replay_Writer *writer, const Game_State *game)
+{
+    flush_pending(writer);
+    write_varint(writer, 0);
+    write_u32(writer, writer->tick);
+    write_u32(writer, writer->event_count);
+    write_u32(writer, (u32)game->points);
+    write_u32(writer, (u32)game->line_count);
+    write_u32(writer, (u32)game->level);
+    write_u32(writer, (u32)game->piece_count);
+    write_u32(writer, writer->checksum);
+    bool ok = !ferror(writer->file);
+    ok = fclose(writer->file) == 0 && ok;
+    writer->file = 0;
+    return ok;
+}
+
+inline u32 read_u32(const u8 *data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((u32)data[3] << 24);
+}
+
+bool read_varint(const u8 **cursor, const u8 *end, u64 *value)
+{
+    u64 result = 0;
+    for (int shift = 0;shift < 64 && *cursor < end;shift += 7)
+    {
+        u8 byte = *(*cursor)++;
+        result |= (u64)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline size_t replay_header_size(int version)
+{
+    return version == 1 ? REPLAY_HEADER_SIZE_V1 : REPLAY_HEADER_SIZE;
+}
+
+bool replay_read_info(const u8 *data, size_t size, Replay_Info *info)
+{
+    if (size < REPLAY_HEADER_SIZE_V1 || memcmp(data, "TRPL", 4) != 0)
+    {
+        return false;
+    }
+    info->version = (u16)(data[4] | (data[5] << 8));
+    if ((info->version != 1 && info->version != REPLAY_VERSION) ||
+        size < replay_header_size(info->version) + 1 + REPLAY_TRAILER_SIZE)
+    {
+        return false;
+    }
+    info->seed = read_u32(data + 8) | ((u64)read_u32(data + 12) << 32);
+    info->randomizer = (Randomizer)data[16];
+    info->start_level = data[18] | (data[19] << 8);
+    info->das = info->version == 1 ? 0 : data[20];
+    info->arr = info->version == 1 ? 0 : data[21];
+
+    const u8 *trailer = data + size - REPLAY_TRAILER_SIZE;
+    info->tick_count = read_u32(trailer);
+    info->event_count = read_u32(trailer + 4);
+    info->points = (int)read_u32(trailer + 8);
+    info->line_count = (int)read_u32(trailer + 12);
+    info->level = (int)read_u32(trailer + 16);
+    info->piece_count = read_u32(trailer + 20);
+    return true;
+}
+
+void replay_verify(const u8 *data, size_t size, Replay_Result *result)
+{
+    memset(result, 0, sizeof(*result));
+    if (!replay_read_info(data, size, &result->recorded))
+    {
+        result->error = "not a replay file or unsupported version";
+        return;
+    }
+    const Replay_Info *info = &result->recorded;
+    size_t checked_size = size - 4;
+    if (fnv1a(FNV_OFFSET, data, checked_size) != read_u32(data + checked_size))
+    {
+        result->error = "checksum mismatch";
+        return;
+    }
+
+    const u8 *cursor = data + replay_header_size(info->version);
+    const u8 *end = data + size - REPLAY_TRAILER_SIZE;
+    int delta_shift = info->version == 1 ? 6 : 7;
+    u64 value = 0;
+    u64 event_tick = 0;
+    u32 events = 0;
+    if (!read_varint(&cursor, end, &value))
+    {
+        result->error = "truncated event stream";
+        return;
+    }
+    event_tick = value >> delta_shift;
+
+    Game_State game;
+    game_init(&game, info->seed, info->randomizer);
+    game.das = info->das;
+    game.arr = info->arr;
+    game_begin(&game, info->start_level);
+
+    Input_State input = {};
+    u8 held = 0;
+    u8 release = 0;
+    for (u32 tick = 0;tick < info->tick_count;++tick)
+    {
+        u8 prev_held = held;
+        u8 pressed = 0;
+        held &= ~release;
+        release = 0;
+        while (value && event_tick == tick)
+        {
+            u8 keys = value & 0x1F;
+            int kind = (int)(value >> 5) & ((1 << (delta_shift - 5)) - 1);
+            switch (kind)
+            {
+            case REPLAY_EVENT_TOGGLE:
+                held ^= keys;
+                break;
+            case REPLAY_EVENT_TAP:
+                held |= keys;
+                release |= keys;
+                break;
+            case REPLAY_EVENT_PRESS:
+                pressed |= keys;
+                break;
+            default:
+                result->error = "unknown event kind";
+                return;
+            }
+            ++events;
+            if (!read_varint(&cursor, end, &value))
+            {
+                result->error = "truncated event stream";
+                return;
+            }
+            event_tick += value >> delta_shift;
+        }
+        input_set_keys(&input, held, prev_held, pressed);
+        update_game(&game, &input);
+    }
+    result->points = game.points;
+    result->line_count = game.line_count;
+    result->level = game.level;
+
+    if (value != 0 || events != info->event_count || cursor != end)
+    {
+        result->error = "events do not match the recorded tick count";
+        return;
+    }
+    if (game.points != info->points || game.line_count != info->line_count ||
+        game.level != info->level || (u32)game.piece_count != info->piece_count)
+    {
+        result->error = "final state differs from the recording";
+        return;
+    }
+    result->ok = true;
+}
+
+void replay_verify_file(const char *path, Replay_Result *result)
+{
+    Mapped_File file;
+    if (!map_file(path, &file))
+    {
+        memset(result, 0, sizeof(*result));
+        result->error = "cannot open file";
+        return;
+    }
+    replay_verify(file.data, file.size, result);
+    unmap_file(&file);
+}
@@ -0,0 +1,85 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "game.h"
+
+// Replay file, all integers little-endian:
+//   header   "TRPL", u16 version, u16 flags, u64 seed, u8 randomizer,
+//            u8 reserved, u16 start_level, u8 das, u8 arr
+//   events   varint (tick_delta << 7 | kind << 5 | keys), terminated by 0.
+//            keys is a mask of INPUT_KEY_*. A toggle flips the keys on that
+//            tick. A tap presses keys on that tick and releases them on the
+//            next, which is how bots and most players hit a key. A press
+//            marks keys pressed on that tick without changing whether they
+//            are held at its end, for keys pressed and released within it.
+//   trailer  u32 tick_count, u32 event_count, i32 points, i32 line_count,
+//            i32 level, u32 piece_count, u32 checksum of all bytes before it
+// The game is game_init(seed) with das and arr set, game_begin(start_level),
+// then tick_count calls to update_game.
+// Version 1 has no das and arr in the header, which means auto-shift off,
+// and its events are (tick_delta << 6 | tap << 5 | keys).
+
+#define REPLAY_VERSION 2
+#define REPLAY_HEADER_SIZE 22
+#define REPLAY_HEADER_SIZE_V1 20
+#define REPLAY_TRAILER_SIZE 28
+
+enum Replay_Event_Kind
+{
+    REPLAY_EVENT_TOGGLE,
+    REPLAY_EVENT_TAP,
+    REPLAY_EVENT_PRESS
+};
+
+struct Replay_Info
+{
+    u16 version;
+    u64 seed;
+    Randomizer randomizer;
+    int start_level;
+    int das;
+    int arr;
+    u32 tick_count;
+    u32 event_count;
+    int points;
+    int line_count;
+    int level;
+    u32 piece_count;
+};
+
+struct Replay_Writer
+{
+    FILE *file;
+    u32 checksum;
+    u32 tick;
+    u32 last_event_tick;
+    u32 event_count;
+    u8 held;
+    bool has_pending;
+    u32 pending_tick;
+    u8 pending_keys;
+    u8 pending_held;
+};
+
+struct Replay_Result
+{
+    bool ok;
+    const char *error;
+    Replay_Info recorded;
+    int points;
+    int line_count;
+    int level;
+};
+
+bool replay_writer_open(Replay_Writer *writer, const char *path, const Game_State *game);
+// Call once per tick, before update_game, with the input for that tick.
+void replay_writer_tick(Replay_Writer *writer, const Input_State *input);
+bool replay_writer_close(Replay_Writer *writer, const Game_State *game);
+
+bool replay_read_info(const u8 *data, size_t size, Replay_Info *info);
+void replay_verify(const u8 *data, size_t size, Replay_Result *result);
+void replay_verify_file(const char *path, Replay_Result *result);
+
+#endif
@@ -0,0 +1,107 @@
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "replay.h"
+#include "thread_pool.h"
+
+struct Verify_Job
+{
+    std::vector<std::string> paths;
+    std::vector<Replay_Result> results;
+};
+
+void verify_body(u32 begin, u32 end, int, void *user)
+{
+    Verify_Job *job = (Verify_Job *)user;
+    for (u32 i = begin;i < end;++i)
+    {
+        replay_verify_file(job->paths[i].c_str(), &job->results[i]);
+    }
+}
+
+void collect_paths(const char *path, std::vector<std::string> *paths)
+{
+    DIR *dir = opendir(path);
+    if (!dir)
+    {
+        paths->push_back(path);
+        return;
+    }
+    while (dirent *entry = readdir(dir))
+    {
+        size_t length = strlen(entry->d_name);
+        if (length > 5 && strcmp(entry->d_name + length - 5, ".trpl") == 0)
+        {
+            paths->push_back(std::string(path) + "/" + entry->d_name);
+        }
+    }
+    closedir(dir);
+}
+
+int print_info(const char *path)
+{
+    Replay_Result result;
+    replay_verify_file(path, &result);
+    const Replay_Info *info = &result.recorded;
+    if (!info->version)
+    {
+        fprintf(stderr, "%s: %s\n", path, result.error);
+        return 1;
+    }
+    printf("version: %d\nseed: %llu\nrandomizer: %s\nstart level: %d\ndas: %d, arr: %d\n"
+           "ticks: %u\nevents: %u\npieces: %u\npoints: %d\nlines: %d\nlevel: %d\n",
+           info->version, (unsigned long long)info->seed,
+           info->randomizer == RANDOMIZER_BAG ? "bag" : "uniform", info->start_level,
+           info->das, info->arr,
+           info->tick_count, info->event_count, info->piece_count,
+           info->points, info->line_count, info->level);
+    printf("verified: %s\n", result.ok ? "ok" : result.error);
+    return result.ok ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc >= 3 && strcmp(argv[1], "info") == 0)
+    {
+        return print_info(argv[2]);
+    }
+    if (argc < 3 || strcmp(argv[1], "verify") != 0)
+    {
+        printf("usage: %s verify [-t threads] <file or directory>...\n"
+               "       %s info <file>\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    int thread_count = 0;
+    Verify_Job job;
+    for (int i = 2;i < argc;++i)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            thread_count = atoi(argv[++i]);
+            continue;
+        }
+        collect_paths(argv[i], &job.paths);
+    }
+    job.results.resize(job.paths.size());
+
+    Thread_Pool *pool = thread_pool_create(thread_count);
+    thread_pool_for(pool, (u32)job.paths.size(), 16, verify_body, &job);
+    thread_pool_destroy(pool);
+
+    int failed = 0;
+    for (size_t i = 0;i < job.paths.size();++i)
+    {
+        if (!job.results[i].ok)
+        {
+            fprintf(stderr, "%s: %s\n", job.paths[i].c_str(), job.results[i].error);
+            ++failed;
+        }
+    }
+    printf("%zu replays, %zu ok, %d failed\n", job.paths.size(),
+           job.paths.size() - failed, failed);
+    return failed ? 1 : 0;
+}
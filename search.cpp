@@ -0,0 +1,201 @@
+#include <string.h>
+#include "search.h"
+
+#define SEARCH_PAD 3
+#define SEARCH_ROWS (HEIGHT + SEARCH_PAD)
+#define SEARCH_COLS (WIDTH + SEARCH_PAD)
+#define SEARCH_NODES (4 * SEARCH_ROWS * SEARCH_COLS)
+#define FOOTPRINT_SLOTS 512
+
+struct Search_Node
+{
+    short parent;
+    u8 move;
+    u8 visited;
+    // Moves from the start, which is the path length before the drop.
+    u8 depth;
+};
+
+inline int node_index(const Piece_State *piece)
+{
+    return (piece->rotation * SEARCH_ROWS + piece->offset_row + SEARCH_PAD) * SEARCH_COLS
+        + piece->offset_col + SEARCH_PAD;
+}
+
+inline Piece_State node_piece(u8 tetrino_index, int index)
+{
+    Piece_State piece = {};
+    piece.tetrino_index = tetrino_index;
+    piece.offset_col = index % SEARCH_COLS - SEARCH_PAD;
+    index /= SEARCH_COLS;
+    piece.offset_row = index % SEARCH_ROWS - SEARCH_PAD;
+    piece.rotation = index / SEARCH_ROWS;
+    return piece;
+}
+
+inline u64 footprint_key(const Piece_State *piece)
+{
+    const Tetrino_Shape *shape = tetrino_shape(piece->tetrino_index, piece->rotation);
+    u64 key = (u64)(piece->offset_row + shape->min_row);
+    for (int row = shape->min_row;row <= shape->max_row;++row)
+    {
+        u64 mask = piece->offset_col >= 0
+            ? (u64)shape->row_masks[row] << piece->offset_col
+            : (u64)shape->row_masks[row] >> -piece->offset_col;
+        key |= mask << (5 + WIDTH * (row - shape->min_row));
+    }
+    return key;
+}
+
+inline Piece_State apply_move(Piece_State piece, int move)
+{
+    switch (move)
+    {
+    case MOVE_LEFT:
+        --piece.offset_col;
+        break;
+    case MOVE_RIGHT:
+        ++piece.offset_col;
+        break;
+    case MOVE_ROTATE:
+        piece.rotation = (piece.rotation + 1) % 4;
+        break;
+    case MOVE_DOWN:
+        ++piece.offset_row;
+        break;
+    }
+    return piece;
+}
+
+void build_path(const Search_Node *nodes, int index, Placement *placement)
+{
+    u8 reversed[MAX_PATH_LENGTH];
+    int length = 0;
+    while (nodes[index].parent >= 0)
+    {
+        reversed[length++] = nodes[index].move;
+        index = nodes[index].parent;
+    }
+    for (int i = 0;i < length;++i)
+    {
+        placement->path[i] = reversed[length - 1 - i];
+    }
+    placement->path[length++] = MOVE_DROP;
+    placement->path_length = length;
+}
+
+int generate_placements(const u16 *rows, const Piece_State *start, Placement_List *out)
+{
+    Search_Node nodes[SEARCH_NODES];
+    short queue[SEARCH_NODES];
+    u64 footprints[FOOTPRINT_SLOTS];
+    memset(nodes, 0, sizeof(nodes));
+    memset(footprints, 0, sizeof(footprints));
+    out->count = 0;
+
+    if (!check_piece_valid<WIDTH, HEIGHT>(start, rows))
+    {
+        return 0;
+    }
+    Game_Board::Column columns[WIDTH];
+    build_columns<WIDTH, HEIGHT>(rows, columns);
+
+    int head = 0;
+    int tail = 0;
+    int start_index = node_index(start);
+    nodes[start_index].parent = -1;
+    nodes[start_index].visited = 1;
+    queue[tail++] = (short)start_index;
+
+    while (head < tail)
+    {
+        int index = queue[head++];
+        Piece_State piece = node_piece(start->tetrino_index, index);
+
+        Piece_State landing = piece;
+        landing.offset_row += drop_distance<WIDTH, HEIGHT>(&piece, columns);
+
+        u64 key = footprint_key(&landing) + 1;
+        u32 slot = (u32)((key * 0x9E3779B97F4A7C15ull) >> 55) & (FOOTPRINT_SLOTS - 1);
+        while (footprints[slot] && footprints[slot] != key)
+        {
+            slot = (slot + 1) & (FOOTPRINT_SLOTS - 1);
+        }
+        if (!footprints[slot] && out->count < MAX_PLACEMENTS)
+        {
+            footprints[slot] = key;
+            Placement *placement = out->placements + out->count++;
+            placement->piece = landing;
+            build_path(nodes, index, placement);
+        }
+
+        // Paths end with a drop, so a node this deep has no room for a
+        // move. Breadth first, every node is reached by a shortest path and
+        // only placements that take more moves than a path holds are lost.
+        if (nodes[index].depth == MAX_PATH_LENGTH - 1)
+        {
+            continue;
+        }
+        for (int move = MOVE_LEFT;move <= MOVE_DOWN;++move)
+        {
+            Piece_State next = apply_move(piece, move);
+            if (!check_piece_valid<WIDTH, HEIGHT>(&next, rows))
+            {
+                continue;
+            }
+            int next_index = node_index(&next);
+            if (nodes[next_index].visited)
+            {
+                continue;
+            }
+            nodes[next_index].visited = 1;
+            nodes[next_index].parent = (short)index;
+            nodes[next_index].move = (u8)move;
+            nodes[next_index].depth = (u8)(nodes[index].depth + 1);
+            queue[tail++] = (short)next_index;
+        }
+    }
+    return out->count;
+}
+
+int apply_placement(const u16 *rows, const Piece_State *piece, u16 *rows_out,
+                    u64 *hash)
+{
+    u64 unused = 0;
+    if (!hash)
+    {
+        hash = &unused;
+    }
+    memcpy(rows_out, rows, HEIGHT * sizeof(u16));
+    const Tetrino_Shape *shape = tetrino_shape(piece->tetrino_index, piece->rotation);
+    for (int row = shape->min_row;row <= shape->max_row;++row)
+    {
+        u16 mask = piece->offset_col >= 0
+            ? (u16)(shape->row_masks[row] << piece->offset_col)
+            : (u16)(shape->row_masks[row] >> -piece->offset_col);
+        rows_out[piece->offset_row + row] |= mask;
+        *hash ^= zobrist_row(piece->offset_row + row, mask);
+    }
+
+    u16 full_row = (u16)((1 << WIDTH) - 1);
+    int cleared = 0;
+    for (int row = HEIGHT - 1;row >= 0;--row)
+    {
+        if (rows_out[row] == full_row)
+        {
+            ++cleared;
+        }
+        else if (cleared)
+        {
+            *hash ^= zobrist_row(row + cleared, rows_out[row + cleared])
+                ^ zobrist_row(row + cleared, rows_out[row]);
+            rows_out[row + cleared] = rows_out[row];
+        }
+    }
+    for (int row = 0;row < cleared;++row)
+    {
+        *hash ^= zobrist_row(row, rows_out[row]);
+        rows_out[row] = 0;
+    }
+    return cleared;
+}
@@ -0,0 +1,46 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "game.h"
+
+// The search, evaluator and bot only play the standard board.
+static_assert(std::is_same<Game_Board::Row, u16>::value, "bot code expects 16-bit rows");
+
+#define MAX_PATH_LENGTH 48
+#define MAX_PLACEMENTS 256
+
+enum Move
+{
+    MOVE_LEFT,
+    MOVE_RIGHT,
+    MOVE_ROTATE,
+    MOVE_DOWN,
+    MOVE_DROP
+};
+
+struct Placement
+{
+    Piece_State piece;
+    u8 path[MAX_PATH_LENGTH];
+    int path_length;
+};
+
+struct Placement_List
+{
+    Placement placements[MAX_PLACEMENTS];
+    int count;
+};
+
+// Finds every position where the piece can lock, starting from start and
+// using single left/right/rotate/soft drop steps. Placements that cover the
+// same cells are reported once. Each path ends with MOVE_DROP and ignores
+// gravity, which only ever moves the piece along a path the search covers.
+int generate_placements(const u16 *rows, const Piece_State *start, Placement_List *out);
+
+// Locks piece into a copy of rows and clears filled lines. Returns the
+// number of lines cleared. When hash is given it holds the Zobrist hash of
+// rows and is updated to match rows_out.
+int apply_placement(const u16 *rows, const Piece_State *piece, u16 *rows_out,
+                    u64 *hash = 0);
+
+#endif
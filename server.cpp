@@ -0,0 +1,409 @@
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "batch.h"
+#include "profile.h"
+#include "server.h"
+
+#define SERVER_MAX_EVENTS 256
+#define SERVER_MAX_CATCH_UP_TICKS (TICKS_PER_SECOND / 4)
+#define SERVER_TICK_GRAIN 64
+
+inline void put_u16(u8 *out, u16 value)
+{
+    out[0] = (u8)value;
+    out[1] = (u8)(value >> 8);
+}
+
+inline void put_u32(u8 *out, u32 value)
+{
+    out[0] = (u8)value;
+    out[1] = (u8)(value >> 8);
+    out[2] = (u8)(value >> 16);
+    out[3] = (u8)(value >> 24);
+}
+
+inline u16 get_u16(const u8 *data)
+{
+    return (u16)(data[0] | (data[1] << 8));
+}
+
+inline u32 get_u32(const u8 *data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((u32)data[3] << 24);
+}
+
+void server_encode_state(const Game_State *game, u8 *out)
+{
+    out[0] = SERVER_MSG_STATE;
+    put_u32(out + 1, (u32)game->time);
+    out[5] = (u8)game->phase;
+    out[6] = game->piece.tetrino_index;
+    out[7] = (u8)game->piece.offset_row;
+    out[8] = (u8)game->piece.offset_col;
+    out[9] = (u8)game->piece.rotation;
+    out[10] = (u8)game->landing_row;
+    put_u32(out + 11, (u32)game->points);
+    put_u16(out + 15, (u16)game->line_count);
+    put_u16(out + 17, (u16)game->level);
+    memcpy(out + 19, game->next_pieces, NEXT_PIECE_COUNT);
+    for (int row = 0;row < HEIGHT;++row)
+    {
+        put_u16(out + 19 + NEXT_PIECE_COUNT + row * 2, game->board.rows[row]);
+    }
+}
+
+void server_decode_state(const u8 *data, Server_State *state)
+{
+    memset(state, 0, sizeof(*state));
+    state->time = get_u32(data + 1);
+    state->phase = (Game_Phase)data[5];
+    state->piece.tetrino_index = data[6];
+    state->piece.offset_row = (signed char)data[7];
+    state->piece.offset_col = (signed char)data[8];
+    state->piece.rotation = data[9];
+    state->landing_row = (signed char)data[10];
+    state->points = (int)get_u32(data + 11);
+    state->line_count = get_u16(data + 15);
+    state->level = get_u16(data + 17);
+    memcpy(state->next_pieces, data + 19, NEXT_PIECE_COUNT);
+    for (int row = 0;row < HEIGHT;++row)
+    {
+        state->rows[row] = get_u16(data + 19 + NEXT_PIECE_COUNT + row * 2);
+    }
+}
+
+int open_listen_socket(Server_Config *config)
+{
+    int fd = -1;
+    if (config->unix_path)
+    {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (strlen(config->unix_path) >= sizeof(address.sun_path))
+        {
+            return -1;
+        }
+        strcpy(address.sun_path, config->unix_path);
+        unlink(config->unix_path);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0 || bind(fd, (sockaddr *)&address, sizeof(address)) < 0)
+        {
+            goto fail;
+        }
+    }
+    else
+    {
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons((u16)config->port);
+        if (inet_pton(AF_INET, config->address, &address.sin_addr) != 1)
+        {
+            return -1;
+        }
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int reuse = 1;
+        if (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0 ||
+            bind(fd, (sockaddr *)&address, sizeof(address)) < 0)
+        {
+            goto fail;
+        }
+        socklen_t length = sizeof(address);
+        getsockname(fd, (sockaddr *)&address, &length);
+        config->port = ntohs(address.sin_port);
+    }
+    if (listen(fd, SOMAXCONN) == 0)
+    {
+        return fd;
+    }
+fail:
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    return -1;
+}
+
+bool server_init(Server *server, const Server_Config *config)
+{
+    server->config = *config;
+    server->listen_fd = -1;
+    server->epoll_fd = -1;
+    server->pool = 0;
+    server->sessions = 0;
+    server->session_count = 0;
+    server->game_index = 0;
+    server->stop = false;
+    memset(&server->stats, 0, sizeof(server->stats));
+    server->states_sent = 0;
+    memset(&server->sessions_pool, 0, sizeof(server->sessions_pool));
+
+    if (!pool_init(&server->sessions_pool, sizeof(Session), config->max_sessions))
+    {
+        return false;
+    }
+    server->sessions = new Session *[config->max_sessions];
+    server->listen_fd = open_listen_socket(&server->config);
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (server->listen_fd < 0 || server->epoll_fd < 0)
+    {
+        server_free(server);
+        return false;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = 0;
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->listen_fd, &event);
+    server->pool = thread_pool_create(config->thread_count);
+    return true;
+}
+
+void server_free(Server *server)
+{
+    for (u32 i = 0;i < server->session_count;++i)
+    {
+        close(server->sessions[i]->fd);
+    }
+    server->session_count = 0;
+    if (server->pool)
+    {
+        thread_pool_destroy(server->pool);
+        server->pool = 0;
+    }
+    if (server->epoll_fd >= 0)
+    {
+        close(server->epoll_fd);
+        server->epoll_fd = -1;
+    }
+    if (server->listen_fd >= 0)
+    {
+        close(server->listen_fd);
+        server->listen_fd = -1;
+        if (server->config.unix_path)
+        {
+            unlink(server->config.unix_path);
+        }
+    }
+    delete[] server->sessions;
+    server->sessions = 0;
+    pool_free(&server->sessions_pool);
+}
+
+void start_session_game(Server *server, Session *session)
+{
+    u64 seed = batch_game_seed(server->config.seed, server->game_index++);
+    game_init(&session->game, seed, RANDOMIZER_BAG);
+    session->game.das = DEFAULT_DAS;
+    session->game.arr = DEFAULT_ARR;
+    game_begin(&session->game, 0);
+}
+
+void accept_sessions(Server *server)
+{
+    for (;;)
+    {
+        int fd = accept4(server->listen_fd, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;
+        }
+        Session *session = (Session *)pool_alloc(&server->sessions_pool);
+        if (!session)
+        {
+            close(fd);
+            ++server->stats.rejected;
+            continue;
+        }
+        if (!server->config.unix_path)
+        {
+            int no_delay = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+        }
+        session->fd = fd;
+        session->index = server->session_count;
+        server->sessions[server->session_count++] = session;
+        start_session_game(server, session);
+
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = session;
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        ++server->stats.accepted;
+    }
+}
+
+void parse_input(Session *session)
+{
+    int offset = 0;
+    while (offset < session->in_size)
+    {
+        const u8 *message = session->in + offset;
+        if (message[0] != SERVER_MSG_INPUT)
+        {
+            session->closed = true;
+            return;
+        }
+        if (session->in_size - offset < SERVER_INPUT_SIZE)
+        {
+            break;
+        }
+        session->held = message[1] & 0x1F;
+        session->pressed |= message[2] & 0x1F;
+        offset += SERVER_INPUT_SIZE;
+    }
+    session->in_size -= offset;
+    memmove(session->in, session->in + offset, session->in_size);
+}
+
+void read_session(Session *session)
+{
+    while (!session->closed)
+    {
+        ssize_t count = recv(session->fd, session->in + session->in_size,
+                             SESSION_IN_CAPACITY - session->in_size, 0);
+        if (count > 0)
+        {
+            session->in_size += (int)count;
+            parse_input(session);
+            continue;
+        }
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            session->closed = true;
+        }
+        return;
+    }
+}
+
+// States that do not fit the output buffer of a slow client are dropped, and
+// the next tick tries again with a newer one.
+void flush_session(Session *session)
+{
+    if (session->out_size == 0)
+    {
+        return;
+    }
+    ssize_t count = send(session->fd, session->out, session->out_size,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (count > 0)
+    {
+        session->out_size -= (int)count;
+        memmove(session->out, session->out + count, session->out_size);
+    }
+    else if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+    {
+        session->closed = true;
+    }
+}
+
+void tick_sessions(u32 begin, u32 end, int, void *user)
+{
+    Server *server = (Server *)user;
+    u64 sent = 0;
+    for (u32 i = begin;i < end;++i)
+    {
+        Session *session = server->sessions[i];
+        if (session->closed)
+        {
+            continue;
+        }
+        input_set_keys(&session->input, session->held, session->prev_held, session->pressed);
+        session->prev_held = session->held;
+        session->pressed = 0;
+        update_game(&session->game, &session->input);
+
+        u64 hash = game_hash(&session->game) ^ session->game.phase;
+        if ((hash != session->last_hash || session->game.events) &&
+            session->out_size + SERVER_STATE_SIZE <= SESSION_OUT_CAPACITY)
+        {
+            server_encode_state(&session->game, session->out + session->out_size);
+            session->out_size += SERVER_STATE_SIZE;
+            session->last_hash = hash;
+            ++sent;
+        }
+        flush_session(session);
+    }
+    server->states_sent.fetch_add(sent, std::memory_order_relaxed);
+}
+
+void close_sessions(Server *server)
+{
+    for (u32 i = server->session_count;i-- > 0;)
+    {
+        Session *session = server->sessions[i];
+        if (!session->closed)
+        {
+            continue;
+        }
+        close(session->fd);
+        Session *last = server->sessions[--server->session_count];
+        server->sessions[i] = last;
+        last->index = i;
+        pool_release(&server->sessions_pool, session);
+        ++server->stats.closed;
+    }
+}
+
+void server_run(Server *server, Server_Report *report, void *user)
+{
+    epoll_event events[SERVER_MAX_EVENTS];
+    u64 tick_ns = 1000000000ull / TICKS_PER_SECOND;
+    u64 next_tick = profile_time() + tick_ns;
+    u64 next_report = next_tick + 1000000000ull;
+    while (!server->stop.load(std::memory_order_relaxed))
+    {
+        u64 now = profile_time();
+        int timeout = now < next_tick ? (int)((next_tick - now + 999999) / 1000000) : 0;
+        int count = epoll_wait(server->epoll_fd, events, SERVER_MAX_EVENTS, timeout);
+        for (int i = 0;i < count;++i)
+        {
+            if (!events[i].data.ptr)
+            {
+                accept_sessions(server);
+            }
+            else
+            {
+                read_session((Session *)events[i].data.ptr);
+            }
+        }
+
+        now = profile_time();
+        if (now < next_tick)
+        {
+            continue;
+        }
+        thread_pool_for(server->pool, server->session_count, SERVER_TICK_GRAIN,
+                        tick_sessions, server);
+        close_sessions(server);
+        u64 end = profile_time();
+        ++server->stats.ticks;
+        server->stats.session_ticks += server->session_count;
+        server->stats.tick_ns += end - now;
+
+        next_tick += tick_ns;
+        if (end > next_tick + tick_ns * SERVER_MAX_CATCH_UP_TICKS)
+        {
+            next_tick = end + tick_ns;
+        }
+        if (report && end >= next_report)
+        {
+            report(server, user);
+            next_report += 1000000000ull;
+        }
+    }
+}
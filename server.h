@@ -0,0 +1,115 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <atomic>
+#include "game.h"
+#include "pool.h"
+#include "thread_pool.h"
+
+// Wire protocol, every message is a u8 type and a fixed-size payload, all
+// integers little-endian.
+//   client -> server
+//     SERVER_MSG_INPUT    u8 held, u8 pressed
+//                         held is the INPUT_KEY_* mask held now, pressed the
+//                         keys that went down since the previous input, so
+//                         a tap between two ticks is not lost.
+//   server -> client
+//     SERVER_MSG_STATE    u32 time, u8 phase, u8 tetrino, i8 row, i8 col,
+//                         u8 rotation, i8 landing_row, u32 points,
+//                         u16 line_count, u16 level, u8 next[NEXT_PIECE_COUNT],
+//                         u16 rows[HEIGHT]
+//                         Sent after a tick that changed the game. A client
+//                         that falls behind skips states, never gets old ones.
+// Each connection gets its own game as soon as it is accepted. It runs the
+// same phases as the single-player game, so A starts a new one after a game
+// over.
+
+#define SERVER_MSG_INPUT 1
+#define SERVER_MSG_STATE 2
+
+#define SERVER_INPUT_SIZE 3
+#define SERVER_STATE_SIZE (19 + NEXT_PIECE_COUNT + 2 * HEIGHT)
+
+#define SESSION_IN_CAPACITY 64
+#define SESSION_OUT_CAPACITY 1024
+
+struct Server_State
+{
+    u32 time;
+    Game_Phase phase;
+    Piece_State piece;
+    int landing_row;
+    int points;
+    int line_count;
+    int level;
+    u8 next_pieces[NEXT_PIECE_COUNT];
+    u16 rows[HEIGHT];
+};
+
+void server_encode_state(const Game_State *game, u8 *out);
+void server_decode_state(const u8 *data, Server_State *state);
+
+struct Session
+{
+    int fd;
+    u32 index;
+    bool closed;
+    u8 held;
+    u8 prev_held;
+    u8 pressed;
+    u64 last_hash;
+    Game_State game;
+    Input_State input;
+    int in_size;
+    u8 in[SESSION_IN_CAPACITY];
+    int out_size;
+    u8 out[SESSION_OUT_CAPACITY];
+};
+
+struct Server_Config
+{
+    const char *address;
+    int port;
+    // Listens on a Unix socket at this path instead of TCP when set.
+    const char *unix_path;
+    u32 max_sessions;
+    int thread_count;
+    u64 seed;
+};
+
+struct Server_Stats
+{
+    u64 ticks;
+    u64 session_ticks;
+    u64 tick_ns;
+    u32 accepted;
+    u32 rejected;
+    u32 closed;
+};
+
+struct Server
+{
+    Server_Config config;
+    int listen_fd;
+    int epoll_fd;
+    Thread_Pool *pool;
+    Pool_Allocator sessions_pool;
+    Session **sessions;
+    u32 session_count;
+    u32 game_index;
+    std::atomic<bool> stop;
+    Server_Stats stats;
+    std::atomic<u64> states_sent;
+};
+
+typedef void Server_Report(const Server *server, void *user);
+
+bool server_init(Server *server, const Server_Config *config);
+void server_free(Server *server);
+// Accepts connections, reads input and ticks every session at
+// TICKS_PER_SECOND until server->stop is set. Sessions are ticked and
+// their states sent in batches on the thread pool. report, when given, is
+// called on the calling thread once a second.
+void server_run(Server *server, Server_Report *report = 0, void *user = 0);
+
+#endif
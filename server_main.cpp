@@ -0,0 +1,358 @@
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "profile.h"
+#include "server.h"
+
+Server *running_server;
+
+void stop_server(int)
+{
+    if (running_server)
+    {
+        running_server->stop = true;
+    }
+}
+
+// Each connection is a file descriptor, so thousands of sessions or load
+// clients need more than the usual soft limit.
+void raise_file_limit()
+{
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+void print_usage(const char *program)
+{
+    printf("usage: %s serve [-a address] [-p port] [-u unix_path] [-n max_sessions]\n"
+           "                [-t threads] [-s seed]\n"
+           "       %s load [-a address] [-p port] [-u unix_path] [-c clients]\n"
+           "                [-d seconds] [-s seed]\n", program, program);
+}
+
+struct Options
+{
+    Server_Config server;
+    int clients;
+    int seconds;
+};
+
+bool parse_options(int argc, char* argv[], Options *options)
+{
+    options->server.address = "127.0.0.1";
+    options->server.port = 7777;
+    options->server.max_sessions = 16384;
+    options->server.seed = 1;
+    options->clients = 1000;
+    options->seconds = 10;
+    for (int i = 2;i < argc;++i)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : 0;
+        if (!value || arg[0] != '-' || strlen(arg) != 2)
+        {
+            return false;
+        }
+        switch (arg[1])
+        {
+        case 'a':
+            options->server.address = value;
+            break;
+        case 'p':
+            options->server.port = atoi(value);
+            break;
+        case 'u':
+            options->server.unix_path = value;
+            break;
+        case 'n':
+            options->server.max_sessions = (u32)strtoul(value, 0, 10);
+            break;
+        case 't':
+            options->server.thread_count = atoi(value);
+            break;
+        case 's':
+            options->server.seed = strtoull(value, 0, 10);
+            break;
+        case 'c':
+            options->clients = atoi(value);
+            break;
+        case 'd':
+            options->seconds = atoi(value);
+            break;
+        default:
+            return false;
+        }
+        ++i;
+    }
+    return true;
+}
+
+struct Server_Report_State
+{
+    Server_Stats last;
+    u64 last_sent;
+};
+
+void print_report(const Server *server, void *user)
+{
+    Server_Report_State *report = (Server_Report_State *)user;
+    const Server_Stats *stats = &server->stats;
+    const Server_Stats *last = &report->last;
+    u64 sent = server->states_sent.load(std::memory_order_relaxed);
+    u64 ticks = stats->ticks - last->ticks;
+    printf("sessions %u, ticks %llu, session ticks/s %llu, tick %.3f ms, states/s %llu, "
+           "accepted %u, closed %u, rejected %u\n",
+           server->session_count, (unsigned long long)ticks,
+           (unsigned long long)(stats->session_ticks - last->session_ticks),
+           ticks ? (stats->tick_ns - last->tick_ns) / 1e6 / ticks : 0.0,
+           (unsigned long long)(sent - report->last_sent),
+           stats->accepted, stats->closed, stats->rejected);
+    fflush(stdout);
+    report->last = *stats;
+    report->last_sent = sent;
+}
+
+int serve(const Options *options)
+{
+    Server *server = new Server;
+    if (!server_init(server, &options->server))
+    {
+        fprintf(stderr, "cannot listen: %s\n", strerror(errno));
+        delete server;
+        return 1;
+    }
+    if (server->config.unix_path)
+    {
+        printf("listening on %s\n", server->config.unix_path);
+    }
+    else
+    {
+        printf("listening on %s:%d\n", server->config.address, server->config.port);
+    }
+    fflush(stdout);
+
+    running_server = server;
+    signal(SIGINT, stop_server);
+    signal(SIGTERM, stop_server);
+    Server_Report_State report = {};
+    server_run(server, print_report, &report);
+    running_server = 0;
+    server_free(server);
+    delete server;
+    return 0;
+}
+
+struct Load_Client
+{
+    int fd;
+    Rng rng;
+    u8 held;
+    int in_size;
+    u8 in[SERVER_STATE_SIZE * 4];
+    u64 states;
+    bool closed;
+};
+
+int connect_client(const Server_Config *config)
+{
+    int fd;
+    int result;
+    if (config->unix_path)
+    {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, config->unix_path, sizeof(address.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        result = fd < 0 ? -1 : connect(fd, (sockaddr *)&address, sizeof(address));
+    }
+    else
+    {
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons((u16)config->port);
+        inet_pton(AF_INET, config->address, &address.sin_addr);
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        result = fd < 0 ? -1 : connect(fd, (sockaddr *)&address, sizeof(address));
+        int no_delay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+    }
+    if (result < 0)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+// Reads every complete state and checks that it decodes to something a game
+// can be in.
+bool read_states(Load_Client *client)
+{
+    for (;;)
+    {
+        ssize_t count = recv(client->fd, client->in + client->in_size,
+                             sizeof(client->in) - client->in_size, MSG_DONTWAIT);
+        if (count <= 0)
+        {
+            return count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+        }
+        client->in_size += (int)count;
+        int offset = 0;
+        while (client->in_size - offset >= SERVER_STATE_SIZE)
+        {
+            Server_State state;
+            server_decode_state(client->in + offset, &state);
+            if (client->in[offset] != SERVER_MSG_STATE || state.phase > GAME_GAMEOVER ||
+                state.piece.tetrino_index >= ARRAY_COUNT(KHOIGACH))
+            {
+                return false;
+            }
+            ++client->states;
+            offset += SERVER_STATE_SIZE;
+        }
+        client->in_size -= offset;
+        memmove(client->in, client->in + offset, client->in_size);
+    }
+}
+
+// Every client mashes keys like the random batch policy, and a held A also
+// starts a new game after a game over.
+int load(const Options *options)
+{
+    int client_count = options->clients;
+    Load_Client *clients = new Load_Client[client_count]();
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    int connected = 0;
+    for (int i = 0;i < client_count;++i)
+    {
+        Load_Client *client = clients + i;
+        client->fd = connect_client(&options->server);
+        if (client->fd < 0)
+        {
+            fprintf(stderr, "cannot connect client %d: %s\n", i, strerror(errno));
+            client->closed = true;
+            continue;
+        }
+        rng_seed(&client->rng, options->server.seed * 0x9E3779B97F4A7C15ull + i);
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.ptr = client;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client->fd, &event);
+        ++connected;
+    }
+    printf("connected %d of %d clients\n", connected, client_count);
+
+    epoll_event events[256];
+    u64 tick_ns = 1000000000ull / TICKS_PER_SECOND;
+    u64 start = profile_time();
+    u64 end = start + (u64)options->seconds * 1000000000ull;
+    u64 next_tick = start;
+    u64 next_report = start + 1000000000ull;
+    u64 inputs = 0;
+    u64 last_states = 0;
+    int lost = 0;
+    for (u64 now = start;now < end;now = profile_time())
+    {
+        if (now >= next_tick)
+        {
+            for (int i = 0;i < client_count;++i)
+            {
+                Load_Client *client = clients + i;
+                u64 bits = rng_next(&client->rng);
+                if (client->closed || (bits & 0x3) != 0)
+                {
+                    continue;
+                }
+                u8 held = (u8)((bits >> 8) & 0x1F) & (u8)((bits >> 16) & 0x1F);
+                u8 message[SERVER_INPUT_SIZE] = { SERVER_MSG_INPUT, held, (u8)(held & ~client->held) };
+                client->held = held;
+                if (send(client->fd, message, sizeof(message), MSG_NOSIGNAL | MSG_DONTWAIT) ==
+                    (ssize_t)sizeof(message))
+                {
+                    ++inputs;
+                }
+            }
+            next_tick += tick_ns;
+        }
+        if (now >= next_report)
+        {
+            u64 states = 0;
+            for (int i = 0;i < client_count;++i)
+            {
+                states += clients[i].states;
+            }
+            printf("clients %d, states/s %llu, inputs %llu\n", connected - lost,
+                   (unsigned long long)(states - last_states), (unsigned long long)inputs);
+            fflush(stdout);
+            last_states = states;
+            next_report += 1000000000ull;
+        }
+        int timeout = now < next_tick ? (int)((next_tick - now) / 1000000) : 0;
+        int count = epoll_wait(epoll_fd, events, ARRAY_COUNT(events), timeout);
+        for (int i = 0;i < count;++i)
+        {
+            Load_Client *client = (Load_Client *)events[i].data.ptr;
+            if (!client->closed && !read_states(client))
+            {
+                client->closed = true;
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client->fd, 0);
+                ++lost;
+            }
+        }
+    }
+
+    u64 states = 0;
+    for (int i = 0;i < client_count;++i)
+    {
+        states += clients[i].states;
+        if (clients[i].fd >= 0)
+        {
+            close(clients[i].fd);
+        }
+    }
+    double seconds = (profile_time() - start) / 1e9;
+    printf("clients: %d connected, %d lost\nstates: %llu, %.0f/s\ninputs: %llu\n",
+           connected, lost, (unsigned long long)states, states / seconds,
+           (unsigned long long)inputs);
+    close(epoll_fd);
+    delete[] clients;
+    return connected == client_count && lost == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    Options options = {};
+    if (argc < 2 || !parse_options(argc, argv, &options))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+    raise_file_limit();
+    if (strcmp(argv[1], "serve") == 0)
+    {
+        return serve(&options);
+    }
+    if (strcmp(argv[1], "load") == 0)
+    {
+        return load(&options);
+    }
+    print_usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,161 @@
+#include "snapshot.h"
+
+static_assert(offsetof(Game_State, board) == 0 &&
+              sizeof(Game_Board) <= SNAPSHOT_TAIL_OFFSET, "board must come first");
+static_assert(std::is_trivially_copyable<Game_State>::value, "game state must be copyable");
+static_assert(WIDTH * SNAPSHOT_CELL_BITS <= 32, "packed row does not fit a u32");
+
+void snapshot_save(const Game_State *game, Game_Snapshot *snapshot)
+{
+    const u8 *cells = game->board.cells;
+    for (int row = 0;row < HEIGHT;++row)
+    {
+        u32 packed = 0;
+        if (game->board.rows[row])
+        {
+            for (int col = 0;col < WIDTH;++col)
+            {
+                packed |= (u32)cells[row * WIDTH + col] << (col * SNAPSHOT_CELL_BITS);
+            }
+        }
+        snapshot->rows[row] = packed;
+    }
+    memcpy(snapshot->tail, (const u8 *)game + SNAPSHOT_TAIL_OFFSET, SNAPSHOT_TAIL_SIZE);
+}
+
+void snapshot_load(const Game_Snapshot *snapshot, Game_State *game)
+{
+    u8 *cells = game->board.cells;
+    for (int row = 0;row < HEIGHT;++row)
+    {
+        u32 packed = snapshot->rows[row];
+        Game_Board::Row bits = 0;
+        if (!packed)
+        {
+            memset(cells + row * WIDTH, 0, WIDTH);
+            game->board.rows[row] = 0;
+            continue;
+        }
+        for (int col = 0;col < WIDTH;++col)
+        {
+            u8 value = (u8)((packed >> (col * SNAPSHOT_CELL_BITS)) & 0x7);
+            cells[row * WIDTH + col] = value;
+            bits |= (Game_Board::Row)((value != 0) << col);
+        }
+        game->board.rows[row] = bits;
+    }
+    build_columns<WIDTH, HEIGHT>(game->board.rows, game->board.columns);
+    memcpy((u8 *)game + SNAPSHOT_TAIL_OFFSET, snapshot->tail, SNAPSHOT_TAIL_SIZE);
+}
+
+bool snapshot_ring_init(Snapshot_Ring *ring, u32 capacity)
+{
+    if (capacity == 0 || capacity > (1u << 31))
+    {
+        return false;
+    }
+    u32 size = 1;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    ring->snapshots = new Game_Snapshot[size];
+    ring->held = new u8[size];
+    ring->pressed = new u8[size];
+    ring->capacity = size;
+    snapshot_ring_reset(ring, 0, 0);
+    return true;
+}
+
+void snapshot_ring_free(Snapshot_Ring *ring)
+{
+    delete[] ring->snapshots;
+    delete[] ring->held;
+    delete[] ring->pressed;
+    ring->snapshots = 0;
+    ring->held = 0;
+    ring->pressed = 0;
+    ring->capacity = 0;
+}
+
+void snapshot_ring_reset(Snapshot_Ring *ring, u32 tick, u8 held)
+{
+    ring->first_tick = tick;
+    ring->tick = tick;
+    ring->base_held = held;
+}
+
+inline u32 ring_index(const Snapshot_Ring *ring, u32 tick)
+{
+    return tick & (ring->capacity - 1);
+}
+
+inline bool ring_contains(const Snapshot_Ring *ring, u32 tick)
+{
+    return tick - ring->first_tick < ring->tick - ring->first_tick;
+}
+
+inline u8 ring_prev_held(const Snapshot_Ring *ring, u32 tick)
+{
+    return tick == ring->first_tick ? ring->base_held : ring->held[ring_index(ring, tick - 1)];
+}
+
+inline void ring_update(const Snapshot_Ring *ring, Game_State *game, u32 tick)
+{
+    u32 index = ring_index(ring, tick);
+    Input_State input;
+    input_set_keys(&input, ring->held[index], ring_prev_held(ring, tick), ring->pressed[index]);
+    update_game(game, &input);
+}
+
+void snapshot_ring_step(Snapshot_Ring *ring, Game_State *game, u8 held, u8 pressed)
+{
+    if (ring->tick - ring->first_tick == ring->capacity)
+    {
+        ring->base_held = ring->held[ring_index(ring, ring->first_tick)];
+        ++ring->first_tick;
+    }
+    u32 index = ring_index(ring, ring->tick);
+    snapshot_save(game, ring->snapshots + index);
+    ring->held[index] = held;
+    ring->pressed[index] = pressed;
+    ring_update(ring, game, ring->tick);
+    ++ring->tick;
+}
+
+bool snapshot_ring_set_keys(Snapshot_Ring *ring, u32 tick, u8 held, u8 pressed)
+{
+    if (!ring_contains(ring, tick))
+    {
+        return false;
+    }
+    u32 index = ring_index(ring, tick);
+    ring->held[index] = held;
+    ring->pressed[index] = pressed;
+    return true;
+}
+
+bool snapshot_ring_rollback(Snapshot_Ring *ring, Game_State *game, u32 tick)
+{
+    if (!ring_contains(ring, tick))
+    {
+        return false;
+    }
+    snapshot_load(ring->snapshots + ring_index(ring, tick), game);
+    ring_update(ring, game, tick);
+    for (u32 t = tick + 1;t != ring->tick;++t)
+    {
+        snapshot_save(game, ring->snapshots + ring_index(ring, t));
+        ring_update(ring, game, t);
+    }
+    return true;
+}
+
+const Game_Snapshot *snapshot_ring_get(const Snapshot_Ring *ring, u32 tick)
+{
+    if (!ring_contains(ring, tick))
+    {
+        return 0;
+    }
+    return ring->snapshots + ring_index(ring, tick);
+}
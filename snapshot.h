@@ -0,0 +1,53 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include "game.h"
+
+#define SNAPSHOT_CELL_BITS 3
+#define SNAPSHOT_TAIL_OFFSET offsetof(Game_State, board_hash)
+#define SNAPSHOT_TAIL_SIZE (sizeof(Game_State) - SNAPSHOT_TAIL_OFFSET)
+
+// A Game_State with the board packed to 3 bits a cell, one u32 a row. The
+// bit rows and columns are rebuilt from the cells on load, and everything
+// after the board is copied as is.
+struct Game_Snapshot
+{
+    u32 rows[HEIGHT];
+    u8 tail[SNAPSHOT_TAIL_SIZE];
+};
+
+void snapshot_save(const Game_State *game, Game_Snapshot *snapshot);
+void snapshot_load(const Game_Snapshot *snapshot, Game_State *game);
+
+// The state before each of the last capacity ticks and the keys applied on
+// it. Ticks count from the reset and the ring holds [first_tick, tick).
+struct Snapshot_Ring
+{
+    Game_Snapshot *snapshots;
+    u8 *held;
+    u8 *pressed;
+    u32 capacity;
+    u32 first_tick;
+    u32 tick;
+    // Keys held at the end of the tick before first_tick.
+    u8 base_held;
+};
+
+// capacity is rounded up to a power of two. Nothing is allocated after this.
+bool snapshot_ring_init(Snapshot_Ring *ring, u32 capacity);
+void snapshot_ring_free(Snapshot_Ring *ring);
+void snapshot_ring_reset(Snapshot_Ring *ring, u32 tick, u8 held);
+// Saves game, then steps it one tick with the given keys as input_set_keys
+// takes them, dropping the oldest tick when the ring is full.
+void snapshot_ring_step(Snapshot_Ring *ring, Game_State *game, u8 held, u8 pressed);
+// Replaces the keys of a recorded tick. Returns false if the tick is no
+// longer, or not yet, in the ring.
+bool snapshot_ring_set_keys(Snapshot_Ring *ring, u32 tick, u8 held, u8 pressed);
+// Loads the state before tick and steps it forward again with the recorded
+// keys to the current tick, saving fresh snapshots on the way. Returns false
+// and leaves game alone if the tick is not in the ring.
+bool snapshot_ring_rollback(Snapshot_Ring *ring, Game_State *game, u32 tick);
+const Game_Snapshot *snapshot_ring_get(const Snapshot_Ring *ring, u32 tick);
+
+#endif
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include "sound.h"
+
+const char *SOUND_FILES[SOUND_COUNT] = {
+    "sound.wav",
+    "destroy.wav",
+    "next_level.wav",
+    "gameover.wav",
+};
+
+const char *SOUND_ASSETS[SOUND_COUNT] = {
+    ASSET_MUSIC,
+    ASSET_LINE_CLEAR,
+    ASSET_LEVEL_UP,
+    ASSET_GAME_OVER,
+};
+
+Mix_Chunk *load_packed_sound(const Asset_Archive *archive, const char *name)
+{
+    const Asset_Entry *entry = asset_find(archive, name);
+    if (!entry || entry->kind != ASSET_SOUND)
+    {
+        return 0;
+    }
+    const u8 *data = asset_data(archive, entry);
+    int frequency;
+    Uint16 format;
+    int channels;
+    if (Mix_QuerySpec(&frequency, &format, &channels) && (u32)frequency == entry->frequency &&
+        format == entry->format && channels == entry->channels)
+    {
+        // The mixer only reads the samples of a chunk it did not allocate.
+        return Mix_QuickLoad_RAW((Uint8 *)data + entry->samples_offset,
+                                 (Uint32)(entry->size - entry->samples_offset));
+    }
+    return Mix_LoadWAV_RW(SDL_RWFromConstMem(data, (int)entry->size), 1);
+}
+
+void load_sounds(Sound_Bank *bank)
+{
+    for (int i = 0;i < SOUND_COUNT && !bank->cancel.load(std::memory_order_relaxed);++i)
+    {
+        Mix_Chunk *chunk = Mix_LoadWAV(SOUND_FILES[i]);
+        if (!chunk)
+        {
+            fprintf(stderr, "cannot load %s: %s\n", SOUND_FILES[i], Mix_GetError());
+        }
+        bank->chunks[i].store(chunk, std::memory_order_release);
+    }
+}
+
+void sound_bank_load(Sound_Bank *bank, const Asset_Archive *archive)
+{
+    for (int i = 0;i < SOUND_COUNT;++i)
+    {
+        bank->chunks[i].store(0, std::memory_order_relaxed);
+    }
+    bank->cancel.store(false, std::memory_order_relaxed);
+    if (archive && archive->entry_count)
+    {
+        for (int i = 0;i < SOUND_COUNT;++i)
+        {
+            Mix_Chunk *chunk = load_packed_sound(archive, SOUND_ASSETS[i]);
+            if (!chunk)
+            {
+                fprintf(stderr, "cannot load %s from the archive: %s\n", SOUND_ASSETS[i],
+                        Mix_GetError());
+            }
+            bank->chunks[i].store(chunk, std::memory_order_release);
+        }
+        return;
+    }
+    bank->loader = std::thread(load_sounds, bank);
+}
+
+void sound_bank_free(Sound_Bank *bank)
+{
+    bank->cancel.store(true, std::memory_order_relaxed);
+    if (bank->loader.joinable())
+    {
+        bank->loader.join();
+    }
+    for (int i = 0;i < SOUND_COUNT;++i)
+    {
+        Mix_Chunk *chunk = bank->chunks[i].exchange(0, std::memory_order_acquire);
+        if (chunk)
+        {
+            Mix_FreeChunk(chunk);
+        }
+    }
+}
+
+int sound_play(Sound_Bank *bank, Sound_Id id, int loops)
+{
+    Mix_Chunk *chunk = bank->chunks[id].load(std::memory_order_acquire);
+    if (!chunk)
+    {
+        return -1;
+    }
+    return Mix_PlayChannel(-1, chunk, loops);
+}
@@ -0,0 +1,38 @@
+#ifndef SOUND_H
+#define SOUND_H
+
+#include <atomic>
+#include <thread>
+#include "SDL_mixer.h"
+#include "asset_archive.h"
+
+enum Sound_Id
+{
+    SOUND_MUSIC,
+    SOUND_LINE_CLEAR,
+    SOUND_LEVEL_UP,
+    SOUND_GAME_OVER,
+    SOUND_COUNT
+};
+
+struct Sound_Bank
+{
+    std::atomic<Mix_Chunk *> chunks[SOUND_COUNT];
+    std::atomic<bool> cancel;
+    std::thread loader;
+};
+
+// Takes the sounds from the archive when it has them, in place when they
+// are already in the device format, which is quick enough to do right
+// away. Otherwise starts decoding the loose WAV files on a background
+// thread. Call after Mix_OpenAudio so chunks are converted to the device
+// format once. archive may be 0.
+void sound_bank_load(Sound_Bank *bank, const Asset_Archive *archive);
+// Joins the loader and frees every chunk. Call before Mix_CloseAudio, and
+// before closing the archive the sounds came from.
+void sound_bank_free(Sound_Bank *bank);
+
+// Sounds that have not finished loading are skipped.
+int sound_play(Sound_Bank *bank, Sound_Id id, int loops = 0);
+
+#endif
@@ -0,0 +1,394 @@
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include "bot.h"
+#include "spectator.h"
+
+#define SPECTATOR_FRESH 4
+#define SPECTATOR_MAX_CATCH_UP_TICKS (TICKS_PER_SECOND / 4)
+#define SPECTATOR_QUADS_PER_GAME (1 + WIDTH * REAL_HEIGHT + 8)
+
+struct alignas(CACHE_LINE_SIZE) Spectator_Game
+{
+    Game_State game;
+    Input_State input;
+    u32 round;
+};
+
+struct Spectator
+{
+    int game_count;
+    u64 seed;
+    Spectator_Game *games;
+    u8 *policy_states;
+    int policy_state_stride;
+    Thread_Pool *pool;
+    // Triple buffer. The simulation thread fills views[back] and swaps it
+    // into ready with the fresh bit set; spectator_views swaps front with
+    // ready when the fresh bit is set. Neither side ever waits.
+    Spectator_View *views[3];
+    int back;
+    int front;
+    std::atomic<int> ready;
+    std::atomic<bool> running;
+    std::thread thread;
+};
+
+void start_game(Spectator *spectator, u32 index)
+{
+    Spectator_Game *slot = spectator->games + index;
+    u32 game_index = slot->round * spectator->game_count + index;
+    game_init(&slot->game, batch_game_seed(spectator->seed, game_index), RANDOMIZER_BAG);
+    game_begin(&slot->game, 0);
+    slot->input = {};
+    ++slot->round;
+    memset(spectator->policy_states + index * spectator->policy_state_stride, 0,
+           BOT_POLICY.state_size);
+}
+
+void copy_view(Spectator_View *view, const Game_State *game)
+{
+    memcpy(view->cells, game->board.cells, sizeof(view->cells));
+    view->piece = game->piece;
+    view->landing_row = game->landing_row;
+    view->phase = game->phase;
+}
+
+void spectator_step(u32 begin, u32 end, int, void *user)
+{
+    Spectator *spectator = (Spectator *)user;
+    Spectator_View *views = spectator->views[spectator->back];
+    for (u32 index = begin;index < end;++index)
+    {
+        Spectator_Game *slot = spectator->games + index;
+        if (slot->game.phase == GAME_GAMEOVER)
+        {
+            start_game(spectator, index);
+        }
+        Input_State prev_input = slot->input;
+        BOT_POLICY.update(&slot->game, &slot->input,
+                          spectator->policy_states + index * spectator->policy_state_stride,
+                          BOT_POLICY.config);
+        input_update_edges(&slot->input, &prev_input);
+        update_game(&slot->game, &slot->input);
+        copy_view(views + index, &slot->game);
+    }
+}
+
+void spectator_thread(Spectator *spectator)
+{
+    std::chrono::nanoseconds tick(1000000000 / TICKS_PER_SECOND);
+    auto next_tick = std::chrono::steady_clock::now();
+    while (spectator->running.load(std::memory_order_relaxed))
+    {
+        thread_pool_for(spectator->pool, spectator->game_count, 4, spectator_step, spectator);
+        spectator->back = spectator->ready.exchange(spectator->back | SPECTATOR_FRESH,
+                                                    std::memory_order_acq_rel) & 3;
+        next_tick += tick;
+        auto now = std::chrono::steady_clock::now();
+        if (now - next_tick > tick * SPECTATOR_MAX_CATCH_UP_TICKS)
+        {
+            next_tick = now;
+        }
+        std::this_thread::sleep_until(next_tick);
+    }
+}
+
+Spectator *spectator_create(int game_count, u64 seed, int thread_count)
+{
+    Spectator *spectator = new Spectator;
+    spectator->game_count = game_count;
+    spectator->seed = seed;
+    spectator->games = new Spectator_Game[game_count]();
+    spectator->policy_state_stride = (BOT_POLICY.state_size + CACHE_LINE_SIZE - 1) /
+        CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    spectator->policy_states = (u8 *)::operator new[](
+        spectator->policy_state_stride * game_count, std::align_val_t(CACHE_LINE_SIZE));
+    spectator->pool = thread_pool_create(thread_count);
+    for (int i = 0;i < 3;++i)
+    {
+        spectator->views[i] = new Spectator_View[game_count];
+    }
+    for (int index = 0;index < game_count;++index)
+    {
+        start_game(spectator, index);
+        for (int i = 0;i < 3;++i)
+        {
+            copy_view(spectator->views[i] + index, &spectator->games[index].game);
+        }
+    }
+    spectator->back = 0;
+    spectator->ready = 1;
+    spectator->front = 2;
+    spectator->running = true;
+    spectator->thread = std::thread(spectator_thread, spectator);
+    return spectator;
+}
+
+void spectator_destroy(Spectator *spectator)
+{
+    spectator->running = false;
+    spectator->thread.join();
+    thread_pool_destroy(spectator->pool);
+    for (int i = 0;i < 3;++i)
+    {
+        delete[] spectator->views[i];
+    }
+    ::operator delete[](spectator->policy_states, std::align_val_t(CACHE_LINE_SIZE));
+    delete[] spectator->games;
+    delete spectator;
+}
+
+const Spectator_View *spectator_views(Spectator *spectator)
+{
+    if (spectator->ready.load(std::memory_order_relaxed) & SPECTATOR_FRESH)
+    {
+        spectator->front = spectator->ready.exchange(spectator->front,
+                                                     std::memory_order_acq_rel) & 3;
+    }
+    return spectator->views[spectator->front];
+}
+
+// SDL_Vertex and SDL_RenderGeometry came in SDL 2.0.18. Older SDL gets a
+// vertex of the same layout and draws the quads one copy at a time.
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+typedef SDL_Vertex Mesh_Vertex;
+#else
+struct Mesh_Vertex
+{
+    SDL_FPoint position;
+    SDL_Color color;
+    SDL_FPoint tex_coord;
+};
+#endif
+
+struct Spectator_Mesh
+{
+    Mesh_Vertex *vertices;
+    int *indices;
+    int quad_capacity;
+    int quad_count;
+};
+
+void mesh_init(Spectator_Mesh *mesh, int quad_capacity)
+{
+    mesh->vertices = new Mesh_Vertex[quad_capacity * 4];
+    mesh->indices = new int[quad_capacity * 6];
+    mesh->quad_capacity = quad_capacity;
+    mesh->quad_count = 0;
+    const int corners[6] = { 0, 1, 2, 2, 1, 3 };
+    for (int quad = 0;quad < quad_capacity;++quad)
+    {
+        for (int i = 0;i < 6;++i)
+        {
+            mesh->indices[quad * 6 + i] = quad * 4 + corners[i];
+        }
+    }
+}
+
+void mesh_free(Spectator_Mesh *mesh)
+{
+    delete[] mesh->vertices;
+    delete[] mesh->indices;
+}
+
+inline void push_quad(Spectator_Mesh *mesh, float x, float y, float width, float height,
+                      float u0, float u1)
+{
+    Mesh_Vertex *vertex = mesh->vertices + mesh->quad_count++ * 4;
+    SDL_Color white = { 0xFF, 0xFF, 0xFF, 0xFF };
+    vertex[0] = { { x, y }, white, { u0, 0.0f } };
+    vertex[1] = { { x + width, y }, white, { u1, 0.0f } };
+    vertex[2] = { { x, y + height }, white, { u0, 1.0f } };
+    vertex[3] = { { x + width, y + height }, white, { u1, 1.0f } };
+}
+
+inline void push_cell(Spectator_Mesh *mesh, int slot, float x, float y, float cell)
+{
+    push_quad(mesh, x, y, cell, cell,
+              (float)slot / CELL_ATLAS_SLOTS, (float)(slot + 1) / CELL_ATLAS_SLOTS);
+}
+
+struct Spectator_Layout
+{
+    int columns;
+    float cell;
+    float origin_x;
+    float origin_y;
+};
+
+// Picks the column count that gives the largest cells. Each board takes
+// its visible rows plus one cell of spacing each way.
+void spectator_layout(int game_count, int width, int height, Spectator_Layout *layout)
+{
+    layout->columns = 1;
+    layout->cell = 0.0f;
+    for (int columns = 1;columns <= game_count;++columns)
+    {
+        int rows = (game_count + columns - 1) / columns;
+        float cell_x = (float)width / (columns * (WIDTH + 1) + 1);
+        float cell_y = (float)height / (rows * (REAL_HEIGHT + 1) + 1);
+        float cell = cell_x < cell_y ? cell_x : cell_y;
+        if (cell > layout->cell)
+        {
+            layout->cell = cell;
+            layout->columns = columns;
+        }
+    }
+    int rows = (game_count + layout->columns - 1) / layout->columns;
+    layout->origin_x = (width - layout->cell * (layout->columns * (WIDTH + 1) - 1)) / 2;
+    layout->origin_y = (height - layout->cell * (rows * (REAL_HEIGHT + 1) - 1)) / 2;
+}
+
+void push_piece(Spectator_Mesh *mesh, const Piece_State *piece, int slot_base,
+                float x, float y, float cell)
+{
+    const Tetrino_Shape *shape = tetrino_shape(piece->tetrino_index, piece->rotation);
+    for (int i = 0;i < 4;++i)
+    {
+        int row = piece->offset_row + shape->cell_row[i] - (HEIGHT - REAL_HEIGHT);
+        if (row >= 0)
+        {
+            int col = piece->offset_col + shape->cell_col[i];
+            push_cell(mesh, slot_base + shape->value, x + col * cell, y + row * cell, cell);
+        }
+    }
+}
+
+void draw_mesh(SDL_Renderer *renderer, SDL_Texture *atlas, const Spectator_Mesh *mesh)
+{
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    SDL_RenderGeometry(renderer, atlas, mesh->vertices, mesh->quad_count * 4,
+                       mesh->indices, mesh->quad_count * 6);
+    PROFILE_COUNT(PROFILE_COUNTER_DRAW_CALLS);
+#else
+    int atlas_width = 0;
+    int atlas_height = 0;
+    SDL_QueryTexture(atlas, 0, 0, &atlas_width, &atlas_height);
+    for (int quad = 0;quad < mesh->quad_count;++quad)
+    {
+        const Mesh_Vertex *vertex = mesh->vertices + quad * 4;
+        int u0 = (int)lrintf(vertex[0].tex_coord.x * atlas_width);
+        int u1 = (int)lrintf(vertex[3].tex_coord.x * atlas_width);
+        SDL_Rect source = { u0, 0, u1 - u0, atlas_height };
+        // Rounding both edges keeps neighbouring cells from leaving gaps.
+        int x0 = (int)lrintf(vertex[0].position.x);
+        int y0 = (int)lrintf(vertex[0].position.y);
+        int x1 = (int)lrintf(vertex[3].position.x);
+        int y1 = (int)lrintf(vertex[3].position.y);
+        SDL_Rect rect = { x0, y0, x1 - x0, y1 - y0 };
+        SDL_RenderCopy(renderer, atlas, &source, &rect);
+        PROFILE_COUNT(PROFILE_COUNTER_DRAW_CALLS);
+    }
+#endif
+}
+
+void build_mesh(Spectator_Mesh *mesh, const Spectator_View *views, int game_count,
+                const Spectator_Layout *layout)
+{
+    float cell = layout->cell;
+    // The empty board is slot 0 stretched, sampled away from its edges.
+    float empty_u0 = 0.25f / CELL_ATLAS_SLOTS;
+    float empty_u1 = 0.75f / CELL_ATLAS_SLOTS;
+    mesh->quad_count = 0;
+    for (int index = 0;index < game_count;++index)
+    {
+        const Spectator_View *view = views + index;
+        float x = layout->origin_x + (index % layout->columns) * (WIDTH + 1) * cell;
+        float y = layout->origin_y + (index / layout->columns) * (REAL_HEIGHT + 1) * cell;
+        push_quad(mesh, x, y, WIDTH * cell, REAL_HEIGHT * cell, empty_u0, empty_u1);
+        for (int row = HEIGHT - REAL_HEIGHT;row < HEIGHT;++row)
+        {
+            float cell_y = y + (row - (HEIGHT - REAL_HEIGHT)) * cell;
+            for (int col = 0;col < WIDTH;++col)
+            {
+                u8 value = matrix_get(view->cells, WIDTH, row, col);
+                if (value)
+                {
+                    push_cell(mesh, value, x + col * cell, cell_y, cell);
+                }
+            }
+        }
+        if (view->phase == GAME_PLAY)
+        {
+            push_piece(mesh, &view->piece, 0, x, y, cell);
+            Piece_State landing = view->piece;
+            landing.offset_row = view->landing_row;
+            push_piece(mesh, &landing, CELL_ATLAS_OUTLINE, x, y, cell);
+        }
+    }
+}
+
+void spectator_run(Spectator *spectator, int game_count, Render_Context *context)
+{
+    SDL_Renderer *renderer = context->renderer;
+    Profiler *profiler = context->profiler;
+    SDL_Texture *atlas = cell_atlas_create(context);
+    if (!atlas)
+    {
+        fprintf(stderr, "cannot create cell atlas: %s\n", SDL_GetError());
+        return;
+    }
+    Spectator_Mesh mesh;
+    mesh_init(&mesh, game_count * SPECTATOR_QUADS_PER_GAME);
+
+    bool quit = false;
+    while (!quit)
+    {
+        profiler_begin_frame(profiler);
+        u64 events_start = profile_time();
+        SDL_Event e;
+        while (SDL_PollEvent(&e) != 0)
+        {
+            if (e.type == SDL_QUIT)
+            {
+                quit = true;
+            }
+            else if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET)
+            {
+                render_context_reset(context, e.type == SDL_RENDER_DEVICE_RESET);
+                SDL_DestroyTexture(atlas);
+                atlas = cell_atlas_create(context);
+            }
+            else if (e.type == SDL_KEYDOWN && !e.key.repeat)
+            {
+                if (e.key.keysym.sym == SDLK_ESCAPE)
+                {
+                    quit = true;
+                }
+                if (e.key.keysym.sym == SDLK_F3)
+                {
+                    context->show_profile = !context->show_profile;
+                }
+            }
+        }
+        profiler_add(profiler, PROFILE_EVENTS, events_start, profile_time());
+
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        SDL_RenderClear(renderer);
+        {
+            PROFILE_SCOPE(profiler, PROFILE_RENDER_BOARD);
+            int width = 0;
+            int height = 0;
+            SDL_GetRendererOutputSize(renderer, &width, &height);
+            Spectator_Layout layout;
+            spectator_layout(game_count, width, height, &layout);
+            build_mesh(&mesh, spectator_views(spectator), game_count, &layout);
+            draw_mesh(renderer, atlas, &mesh);
+        }
+        if (context->show_profile)
+        {
+            render_profile(context);
+        }
+        {
+            PROFILE_SCOPE(profiler, PROFILE_PRESENT);
+            SDL_RenderPresent(renderer);
+        }
+        profiler_end_frame(profiler);
+    }
+    mesh_free(&mesh);
+    SDL_DestroyTexture(atlas);
+}
@@ -0,0 +1,34 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include "render.h"
+
+#define SPECTATOR_WINDOW_WIDTH 1600
+#define SPECTATOR_WINDOW_HEIGHT 900
+
+// What the render thread needs of one game.
+struct Spectator_View
+{
+    u8 cells[WIDTH * HEIGHT];
+    Piece_State piece;
+    int landing_row;
+    Game_Phase phase;
+};
+
+struct Spectator;
+
+// Starts game_count bot games on a simulation thread, which steps them at
+// TICKS_PER_SECOND across a thread pool of thread_count workers (0 for one
+// per core) and starts a new game whenever one ends.
+Spectator *spectator_create(int game_count, u64 seed, int thread_count);
+void spectator_destroy(Spectator *spectator);
+// The views of the last finished tick. They stay valid and unchanged until
+// the next call.
+const Spectator_View *spectator_views(Spectator *spectator);
+
+// Shows every game in a grid scaled to the window until it is closed. All
+// boards go out in one SDL_RenderGeometry call per frame, textured from
+// the cell atlas, or one SDL_RenderCopy a cell before SDL 2.0.18.
+void spectator_run(Spectator *spectator, int game_count, Render_Context *context);
+
+#endif
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <string.h>
+#include "profile.h"
+#include "text.h"
+
+#define GLYPH_ATLAS_WIDTH 512
+
+inline int glyph_index(char c)
+{
+    int index = (u8)c - GLYPH_FIRST;
+    return index >= 0 && index < GLYPH_COUNT ? index : '?' - GLYPH_FIRST;
+}
+
+bool glyph_atlas_create(Glyph_Atlas *atlas, SDL_Renderer *renderer, TTF_Font *font)
+{
+    memset(atlas, 0, sizeof(*atlas));
+    atlas->height = TTF_FontHeight(font);
+
+    SDL_Color white = { 0xFF, 0xFF, 0xFF, 0xFF };
+    SDL_Surface *surfaces[GLYPH_COUNT] = {};
+    int x = 0;
+    int y = 0;
+    int row_height = 0;
+    for (int i = 0;i < GLYPH_COUNT;++i)
+    {
+        char text[2] = { (char)(GLYPH_FIRST + i), 0 };
+        int minx, maxx, miny, maxy;
+        TTF_GlyphMetrics(font, (Uint16)text[0], &minx, &maxx, &miny, &maxy, &atlas->advance[i]);
+        surfaces[i] = TTF_RenderText_Solid(font, text, white);
+        if (!surfaces[i])
+        {
+            continue;
+        }
+        if (x + surfaces[i]->w > GLYPH_ATLAS_WIDTH)
+        {
+            x = 0;
+            y += row_height;
+            row_height = 0;
+        }
+        atlas->glyphs[i] = SDL_Rect { x, y, surfaces[i]->w, surfaces[i]->h };
+        x += surfaces[i]->w;
+        row_height = surfaces[i]->h > row_height ? surfaces[i]->h : row_height;
+    }
+
+    SDL_Surface *sheet = SDL_CreateRGBSurfaceWithFormat(0, GLYPH_ATLAS_WIDTH, y + row_height,
+                                                        32, SDL_PIXELFORMAT_RGBA32);
+    if (sheet)
+    {
+        SDL_FillRect(sheet, 0, SDL_MapRGBA(sheet->format, 0xFF, 0xFF, 0xFF, 0x00));
+        for (int i = 0;i < GLYPH_COUNT;++i)
+        {
+            if (surfaces[i])
+            {
+                SDL_BlitSurface(surfaces[i], 0, sheet, &atlas->glyphs[i]);
+            }
+        }
+        atlas->texture = SDL_CreateTextureFromSurface(renderer, sheet);
+        SDL_FreeSurface(sheet);
+    }
+    for (int i = 0;i < GLYPH_COUNT;++i)
+    {
+        if (surfaces[i])
+        {
+            SDL_FreeSurface(surfaces[i]);
+        }
+    }
+    if (!atlas->texture)
+    {
+        return false;
+    }
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+void glyph_atlas_free(Glyph_Atlas *atlas)
+{
+    if (atlas->texture)
+    {
+        SDL_DestroyTexture(atlas->texture);
+        atlas->texture = 0;
+    }
+}
+
+int layout_text(const Glyph_Atlas *atlas, const char *text, u8 *glyphs, short *xs, int capacity)
+{
+    int x = 0;
+    int length = 0;
+    for (const char *c = text;*c && length < capacity;++c)
+    {
+        int index = glyph_index(*c);
+        glyphs[length] = (u8)index;
+        xs[length] = (short)x;
+        x += atlas->advance[index];
+        ++length;
+    }
+    return x;
+}
+
+inline int align_x(int x, int width, Text_Align alignment)
+{
+    switch (alignment)
+    {
+    case TEXT_ALIGN_CENTER:
+        return x - width / 2;
+    case TEXT_ALIGN_RIGHT:
+        return x - width;
+    default:
+        return x;
+    }
+}
+
+void draw_glyphs(SDL_Renderer *renderer, const Glyph_Atlas *atlas,
+                 const u8 *glyphs, const short *xs, int length,
+                 int x, int y, SDL_Color color)
+{
+    if (!atlas->texture)
+    {
+        return;
+    }
+    SDL_SetTextureColorMod(atlas->texture, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(atlas->texture, color.a);
+    for (int i = 0;i < length;++i)
+    {
+        const SDL_Rect *source = &atlas->glyphs[glyphs[i]];
+        if (source->w == 0)
+        {
+            continue;
+        }
+        SDL_Rect rect = { x + xs[i], y, source->w, source->h };
+        SDL_RenderCopy(renderer, atlas->texture, source, &rect);
+        PROFILE_COUNT(PROFILE_COUNTER_DRAW_CALLS);
+    }
+}
+
+void draw_string(SDL_Renderer *renderer, const Glyph_Atlas *atlas, const char *text,
+                 int x, int y, Text_Align alignment, SDL_Color color)
+{
+    u8 glyphs[TEXT_LABEL_CAPACITY];
+    short xs[TEXT_LABEL_CAPACITY];
+    int length = (int)strlen(text);
+    length = length < TEXT_LABEL_CAPACITY ? length : TEXT_LABEL_CAPACITY;
+    int width = layout_text(atlas, text, glyphs, xs, length);
+    draw_glyphs(renderer, atlas, glyphs, xs, length, align_x(x, width, alignment), y, color);
+}
+
+void draw_label(SDL_Renderer *renderer, const Glyph_Atlas *atlas, Text_Label *label,
+                const char *format, int value,
+                int x, int y, Text_Align alignment, SDL_Color color)
+{
+    if (label->format != format || label->value != value)
+    {
+        char text[TEXT_LABEL_CAPACITY + 1];
+        snprintf(text, sizeof(text), format, value);
+        label->length = (int)strlen(text);
+        label->width = layout_text(atlas, text, label->glyphs, label->x, TEXT_LABEL_CAPACITY);
+        label->format = format;
+        label->value = value;
+    }
+    draw_glyphs(renderer, atlas, label->glyphs, label->x, label->length,
+                align_x(x, label->width, alignment), y, color);
+}
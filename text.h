@@ -0,0 +1,50 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include "SDL.h"
+#include "SDL_ttf.h"
+#include "game.h"
+
+#define GLYPH_FIRST 32
+#define GLYPH_COUNT 95
+#define TEXT_LABEL_CAPACITY 64
+
+enum Text_Align
+{
+    TEXT_ALIGN_LEFT,
+    TEXT_ALIGN_CENTER,
+    TEXT_ALIGN_RIGHT
+};
+
+// Printable ASCII rendered once in white into a single texture. Strings are
+// drawn glyph by glyph from it and tinted with the texture color mod.
+struct Glyph_Atlas
+{
+    SDL_Texture *texture;
+    SDL_Rect glyphs[GLYPH_COUNT];
+    int advance[GLYPH_COUNT];
+    int height;
+};
+
+// Laid out text for a label that shows one formatted number. The layout is
+// only rebuilt when the number or the format changes.
+struct Text_Label
+{
+    const char *format;
+    int value;
+    int length;
+    int width;
+    u8 glyphs[TEXT_LABEL_CAPACITY];
+    short x[TEXT_LABEL_CAPACITY];
+};
+
+bool glyph_atlas_create(Glyph_Atlas *atlas, SDL_Renderer *renderer, TTF_Font *font);
+void glyph_atlas_free(Glyph_Atlas *atlas);
+
+void draw_string(SDL_Renderer *renderer, const Glyph_Atlas *atlas, const char *text,
+                 int x, int y, Text_Align alignment, SDL_Color color);
+void draw_label(SDL_Renderer *renderer, const Glyph_Atlas *atlas, Text_Label *label,
+                const char *format, int value,
+                int x, int y, Text_Align alignment, SDL_Color color);
+
+#endif
@@ -0,0 +1,217 @@
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "thread_pool.h"
+
+struct alignas(CACHE_LINE_SIZE) Work_Range
+{
+    std::atomic<u64> range;
+};
+
+struct Thread_Pool
+{
+    int thread_count;
+    std::vector<std::thread> threads;
+    Work_Range *ranges;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    u64 generation;
+    int running;
+    bool quit;
+
+    u32 grain;
+    Parallel_Body *body;
+    void *user;
+};
+
+inline u64 pack_range(u32 begin, u32 end)
+{
+    return ((u64)end << 32) | begin;
+}
+
+inline u32 range_begin(u64 range)
+{
+    return (u32)range;
+}
+
+inline u32 range_end(u64 range)
+{
+    return (u32)(range >> 32);
+}
+
+bool pop_own(Thread_Pool *pool, int worker, u32 *begin, u32 *end)
+{
+    std::atomic<u64> *own = &pool->ranges[worker].range;
+    u64 range = own->load(std::memory_order_acquire);
+    for (;;)
+    {
+        u32 b = range_begin(range);
+        u32 e = range_end(range);
+        if (b >= e)
+        {
+            return false;
+        }
+        u32 take = e - b < pool->grain ? e - b : pool->grain;
+        if (own->compare_exchange_weak(range, pack_range(b + take, e),
+                                       std::memory_order_acq_rel))
+        {
+            *begin = b;
+            *end = b + take;
+            return true;
+        }
+    }
+}
+
+bool steal(Thread_Pool *pool, int worker)
+{
+    for (int i = 1;i < pool->thread_count;++i)
+    {
+        int victim = (worker + i) % pool->thread_count;
+        std::atomic<u64> *other = &pool->ranges[victim].range;
+        u64 range = other->load(std::memory_order_acquire);
+        for (;;)
+        {
+            u32 b = range_begin(range);
+            u32 e = range_end(range);
+            if (b >= e)
+            {
+                break;
+            }
+            u32 mid = e - b > pool->grain ? b + (e - b) / 2 : b;
+            if (other->compare_exchange_weak(range, pack_range(b, mid),
+                                             std::memory_order_acq_rel))
+            {
+                pool->ranges[worker].range.store(pack_range(mid, e),
+                                                 std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void run_worker(Thread_Pool *pool, int worker)
+{
+    u32 begin, end;
+    for (;;)
+    {
+        while (pop_own(pool, worker, &begin, &end))
+        {
+            pool->body(begin, end, worker, pool->user);
+        }
+        if (!steal(pool, worker))
+        {
+            return;
+        }
+    }
+}
+
+void worker_main(Thread_Pool *pool, int worker)
+{
+    u64 seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->wake.wait(lock, [&] { return pool->quit || pool->generation != seen; });
+            if (pool->quit)
+            {
+                return;
+            }
+            seen = pool->generation;
+        }
+        run_worker(pool, worker);
+        {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            if (--pool->running == 0)
+            {
+                pool->done.notify_one();
+            }
+        }
+    }
+}
+
+Thread_Pool *thread_pool_create(int thread_count)
+{
+    if (thread_count <= 0)
+    {
+        thread_count = (int)std::thread::hardware_concurrency();
+        if (thread_count <= 0)
+        {
+            thread_count = 1;
+        }
+    }
+    Thread_Pool *pool = new Thread_Pool();
+    pool->thread_count = thread_count;
+    pool->ranges = new Work_Range[thread_count];
+    for (int i = 0;i < thread_count;++i)
+    {
+        pool->ranges[i].range.store(0);
+    }
+    pool->generation = 0;
+    pool->running = 0;
+    pool->quit = false;
+    for (int i = 1;i < thread_count;++i)
+    {
+        pool->threads.emplace_back(worker_main, pool, i);
+    }
+    return pool;
+}
+
+void thread_pool_destroy(Thread_Pool *pool)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->quit = true;
+    }
+    pool->wake.notify_all();
+    for (std::thread &thread : pool->threads)
+    {
+        thread.join();
+    }
+    delete[] pool->ranges;
+    delete pool;
+}
+
+int thread_pool_size(const Thread_Pool *pool)
+{
+    return pool->thread_count;
+}
+
+void thread_pool_for(Thread_Pool *pool, u32 count, u32 grain,
+                     Parallel_Body *body, void *user)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    pool->grain = grain > 0 ? grain : 1;
+    pool->body = body;
+    pool->user = user;
+
+    u32 share = count / pool->thread_count;
+    u32 extra = count % pool->thread_count;
+    u32 begin = 0;
+    for (int i = 0;i < pool->thread_count;++i)
+    {
+        u32 end = begin + share + ((u32)i < extra ? 1 : 0);
+        pool->ranges[i].range.store(pack_range(begin, end), std::memory_order_relaxed);
+        begin = end;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->running = pool->thread_count - 1;
+        ++pool->generation;
+    }
+    pool->wake.notify_all();
+
+    run_worker(pool, 0);
+
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    pool->done.wait(lock, [&] { return pool->running == 0; });
+}
@@ -0,0 +1,23 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "game.h"
+
+#define CACHE_LINE_SIZE 64
+
+typedef void Parallel_Body(u32 begin, u32 end, int worker, void *user);
+
+struct Thread_Pool;
+
+Thread_Pool *thread_pool_create(int thread_count);
+void thread_pool_destroy(Thread_Pool *pool);
+int thread_pool_size(const Thread_Pool *pool);
+
+// Runs body over [0, count) in chunks of at most grain indices. The range is
+// split evenly between the workers up front; a worker that runs dry steals
+// the back half of another worker's remaining range. The calling thread
+// takes part as worker 0 and the call returns once every index is done.
+void thread_pool_for(Thread_Pool *pool, u32 count, u32 grain,
+                     Parallel_Body *body, void *user);
+
+#endif
@@ -0,0 +1,116 @@
+#include <new>
+#include <string.h>
+#include "tt.h"
+
+// data layout: value bits [0, 32), depth [32, 40), generation [40, 64)
+
+inline u64 tt_pack(float value, int depth, u32 generation)
+{
+    u32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits | ((u64)(u8)depth << 32) | ((u64)(generation & 0xFFFFFF) << 40);
+}
+
+inline float tt_value(u64 data)
+{
+    u32 bits = (u32)data;
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline int tt_depth(u64 data)
+{
+    return (int)((data >> 32) & 0xFF);
+}
+
+inline u32 tt_generation(u64 data)
+{
+    return (u32)(data >> 40);
+}
+
+void tt_init(Transposition_Table *table, size_t max_bytes)
+{
+    u64 count = 1;
+    while (count * 2 * sizeof(TT_Bucket) <= max_bytes)
+    {
+        count *= 2;
+    }
+    table->buckets = new TT_Bucket[count];
+    table->bucket_mask = count - 1;
+    table->generation.store(1);
+    tt_clear(table);
+}
+
+void tt_free(Transposition_Table *table)
+{
+    delete[] table->buckets;
+    table->buckets = 0;
+    table->bucket_mask = 0;
+}
+
+void tt_clear(Transposition_Table *table)
+{
+    for (u64 i = 0;i <= table->bucket_mask;++i)
+    {
+        for (int j = 0;j < TT_BUCKET_SIZE;++j)
+        {
+            table->buckets[i].slots[j].check.store(0, std::memory_order_relaxed);
+            table->buckets[i].slots[j].data.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void tt_new_generation(Transposition_Table *table)
+{
+    table->generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t tt_size_bytes(const Transposition_Table *table)
+{
+    return (table->bucket_mask + 1) * sizeof(TT_Bucket);
+}
+
+bool tt_probe(const Transposition_Table *table, u64 key, int depth, float *value)
+{
+    const TT_Bucket *bucket = table->buckets + (key & table->bucket_mask);
+    for (int i = 0;i < TT_BUCKET_SIZE;++i)
+    {
+        u64 data = bucket->slots[i].data.load(std::memory_order_relaxed);
+        u64 check = bucket->slots[i].check.load(std::memory_order_relaxed);
+        if (data && (check ^ data) == key && tt_depth(data) == depth)
+        {
+            *value = tt_value(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void tt_store(Transposition_Table *table, u64 key, int depth, float value)
+{
+    TT_Bucket *bucket = table->buckets + (key & table->bucket_mask);
+    u32 generation = table->generation.load(std::memory_order_relaxed) & 0xFFFFFF;
+    int victim = 0;
+    int victim_score = 0x7FFFFFFF;
+    for (int i = 0;i < TT_BUCKET_SIZE;++i)
+    {
+        u64 data = bucket->slots[i].data.load(std::memory_order_relaxed);
+        u64 check = bucket->slots[i].check.load(std::memory_order_relaxed);
+        if (!data || (check ^ data) == key)
+        {
+            victim = i;
+            break;
+        }
+        int age = (int)((generation - tt_generation(data)) & 0xFFFFFF);
+        int score = tt_depth(data) - age * 4;
+        if (score < victim_score)
+        {
+            victim = i;
+            victim_score = score;
+        }
+    }
+    u64 data = tt_pack(value, depth, generation);
+    bucket->slots[victim].data.store(data, std::memory_order_relaxed);
+    bucket->slots[victim].check.store(key ^ data, std::memory_order_relaxed);
+}
@@ -0,0 +1,40 @@
+#ifndef TT_H
+#define TT_H
+
+#include <atomic>
+#include <stddef.h>
+#include "game.h"
+
+#define TT_BUCKET_SIZE 4
+
+// Each slot stores key ^ data next to data, so a reader that races with a
+// writer sees a key that no longer matches and treats the slot as a miss
+// instead of returning mixed halves. No locks are taken.
+struct TT_Slot
+{
+    std::atomic<u64> check;
+    std::atomic<u64> data;
+};
+
+struct alignas(64) TT_Bucket
+{
+    TT_Slot slots[TT_BUCKET_SIZE];
+};
+
+struct Transposition_Table
+{
+    TT_Bucket *buckets;
+    u64 bucket_mask;
+    std::atomic<u32> generation;
+};
+
+void tt_init(Transposition_Table *table, size_t max_bytes);
+void tt_free(Transposition_Table *table);
+void tt_clear(Transposition_Table *table);
+void tt_new_generation(Transposition_Table *table);
+size_t tt_size_bytes(const Transposition_Table *table);
+
+bool tt_probe(const Transposition_Table *table, u64 key, int depth, float *value);
+void tt_store(Transposition_Table *table, u64 key, int depth, float value);
+
+#endif